@@ -1,5 +1,6 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+#include "core/Conf.hpp"
 
 enum class Mode
 {
@@ -19,22 +20,10 @@ enum class SpawnMode
 namespace conf
 {
 	int FPS = 60;
-	float dt = 1.0 / FPS;
-	const float G = 9.81f;
 
 	int WIDTH = 1280, HEIGHT = 700;
 	float X = 40.0f, Y = 40.0f * (1.0f * HEIGHT / WIDTH);
-
 	float particle_radius = std::min(X, Y) / 200.0f;
-	float h = std::min(X, Y) / 45.0f;										//	interaction radius
-	float k = 5.0f, k_near = 8.0f * 10, k_spring = 0.0f, k_stick = 5.0f;	//	stiffness / near stiffness
-	float density_rest = 10.0f;												//	rest density
-	float yield_ratio = 0.2f, plasticity = 40.0f;							//	yield ratio / plasticity
-	float alpha_viscosity = 4.0f, beta_viscosity = 0.0f;
-	float stickness_distance = h;
-	const float PI = 3.1415;
-
-	const int START_MAX_PARTICLE_AMOUNT = 10000;
 
 	int microseconds_passsed = 0;
 
@@ -52,4 +41,4 @@ namespace conf
 	sf::Color COLOR_PARTICLE(42, 159, 223);
 	sf::Color COLOR_BACKGROUND(33, 35, 33);
 	sf::Color COLOR_OBJECT(255, 255, 255);
-}
\ No newline at end of file
+}
@@ -2,7 +2,7 @@
 #include <SFML/Graphics.hpp>
 #include "Buttons.hpp"
 #include "Conf.hpp"
-#include "Simulation.hpp"
+#include "core/Simulation.hpp"
 
 class Menu : public sf::Drawable
 {
@@ -36,36 +36,36 @@ public:
 		sf::Text text("text", DEFAULT_FONT, 16);
 
 		Slider* interaction_radius = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1); 
-		interaction_radius->setChangingValue(&conf::h, MIN_INTERACTION_RADIUS, MAX_INTERACTION_RADIUS, "interaction radius");
+		interaction_radius->setChangingValue(&sim.config.h, MIN_INTERACTION_RADIUS, MAX_INTERACTION_RADIUS, "interaction radius");
 		interaction_radius->setOnAction([&sim]() {
 			sim.createGrid();
 			});
 
 		Slider* stiffness = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		stiffness->setChangingValue(&conf::k, MIN_STIFFNESS, MAX_STIFFNESS, "stiffness");
+		stiffness->setChangingValue(&sim.config.k, MIN_STIFFNESS, MAX_STIFFNESS, "stiffness");
 
 		Slider* near_stiffness = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		near_stiffness->setChangingValue(&conf::k_near, MIN_NEAR_STIFFNESS, MAX_NEAR_STIFFNESS, "near stiffness");
+		near_stiffness->setChangingValue(&sim.config.k_near, MIN_NEAR_STIFFNESS, MAX_NEAR_STIFFNESS, "near stiffness");
 
 		Slider* stickiness = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		stickiness->setChangingValue(&conf::k_stick, MIN_STICKINESS, MAX_STICKINESS, "stickiness");
+		stickiness->setChangingValue(&sim.config.k_stick, MIN_STICKINESS, MAX_STICKINESS, "stickiness");
 
 		Slider* stickiness_distance = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		stickiness_distance->setChangingValue(&conf::stickness_distance, MIN_STICKINESS_DISTANCE, MAX_STICKINESS_DISTANCE, "stickiness dist.");
+		stickiness_distance->setChangingValue(&sim.config.stickness_distance, MIN_STICKINESS_DISTANCE, MAX_STICKINESS_DISTANCE, "stickiness dist.");
 
 		Slider* rest_density = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		rest_density->setChangingValue(&conf::density_rest, MIN_REST_DENSITY, MAX_REST_DENSITY, "rest density");
+		rest_density->setChangingValue(&sim.config.density_rest, MIN_REST_DENSITY, MAX_REST_DENSITY, "rest density");
 
 		Slider* timeframe = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		timeframe->setChangingValue(&conf::dt, MIN_DT, MAX_DT, "timeframe", 3);
+		timeframe->setChangingValue(&sim.config.dt, MIN_DT, MAX_DT, "timeframe", 3);
 
 		Slider* spring_stiffness = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		spring_stiffness->setChangingValue(&conf::k_spring, MIN_SPRING_STIFFNESS, MAX_SPRING_STIFFNESS, "spring stiffness");
+		spring_stiffness->setChangingValue(&sim.config.k_spring, MIN_SPRING_STIFFNESS, MAX_SPRING_STIFFNESS, "spring stiffness");
 
 		Slider* yield_ratio = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(70.0f, 30.0f), 10.0f), text, 0.5, 1);
-		yield_ratio->setChangingValue(&conf::yield_ratio, MIN_YIELD_RATIO, MAX_YIELD_RATIO, "yield ratio");
+		yield_ratio->setChangingValue(&sim.config.yield_ratio, MIN_YIELD_RATIO, MAX_YIELD_RATIO, "yield ratio");
 		Slider* plasticity = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(70.0f, 30.0f), 10.0f), text, 0.5, 1);
-		plasticity->setChangingValue(&conf::plasticity, MIN_PLASTICITY, MAX_PLASTICITY, "plasticity");
+		plasticity->setChangingValue(&sim.config.plasticity, MIN_PLASTICITY, MAX_PLASTICITY, "plasticity");
 		LinearLayout* yield_plasticity_layout = new LinearLayout(new RoundRectShape(sf::Vector2f(100.0f, 100.0f), sf::Vector2f(150.0f, 50.0f), 10.0f), 1, false);
 		yield_plasticity_layout->widget_padding = 10.0f;
 		yield_plasticity_layout->addItem(yield_ratio);
@@ -73,7 +73,7 @@ public:
 		yield_plasticity_layout->mode = ContainerMode::FIT_WIDGETS;
 
 		Slider* alpha_viscosity = new Slider(new RoundRectShape(sf::Vector2f(200.0f, 200.0f), sf::Vector2f(150.0f, 30.0f), 10.0f), text, 0.5, 1);
-		alpha_viscosity->setChangingValue(&conf::alpha_viscosity, MIN_ALPHA_VISCOSITY, MAX_ALPHA_VISCOSITY, "viscosity");
+		alpha_viscosity->setChangingValue(&sim.config.alpha_viscosity, MIN_ALPHA_VISCOSITY, MAX_ALPHA_VISCOSITY, "viscosity");
 
 		text.setString("delete water");
 		ClickableButton* delete_water = new ClickableButton(new RoundRectShape({ 200.0f, 200.0f }, sf::Vector2f(150.0f, 30.0f), 10.0f), text, 1);
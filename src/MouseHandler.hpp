@@ -1,6 +1,6 @@
 #pragma once
 #include <SFML/Graphics.hpp>
-#include "Simulation.hpp"
+#include "core/Simulation.hpp"
 #include "Spawner.hpp"
 #include "Conf.hpp"
 #include "Objects.hpp"
@@ -10,11 +10,11 @@ class MouseInputHandler : public sf::Drawable
 public:
 	Simulation& sim;
 	bool leftButtonPressed = false, enteringObject = false;
-	sf::Vector2f leftButtonPressedPos = sf::Vector2f(0.0f, 0.0f), rightButtonPressedPos = sf::Vector2f(0.0f, 0.0f);
+	Vec2f leftButtonPressedPos = Vec2f(0.0f, 0.0f), rightButtonPressedPos = Vec2f(0.0f, 0.0f);
 	Spawner spawner;
-	std::vector<sf::Vector2f> polygon_vertices;
+	std::vector<Vec2f> polygon_vertices;
 	CollisionObject* drag_object = nullptr;
-	sf::Vector2f prev_mouse_pos = {0.0f, 0.0f};
+	Vec2f prev_mouse_pos = {0.0f, 0.0f};
 
 	std::vector<sf::CircleShape*> rect_circles;
 
@@ -24,7 +24,7 @@ public:
 	{
 		if (event.type == sf::Event::MouseButtonPressed)
 		{
-			sf::Vector2f mouse_pos = conf::window.mapPixelToCoords(sf::Mouse::getPosition(conf::window));
+			Vec2f mouse_pos = toVec(conf::window.mapPixelToCoords(sf::Mouse::getPosition(conf::window)));
 			mouse_pos.y = conf::Y - mouse_pos.y;
 
 			if (event.mouseButton.button == sf::Mouse::Left)
@@ -33,7 +33,7 @@ public:
 				{
 					if (enteringObject)
 					{
-						sf::Vector2f temp = mouse_pos - leftButtonPressedPos;
+						Vec2f temp = mouse_pos - leftButtonPressedPos;
 						conf::COLOR_OBJECT.a = 255;
 						enteringObject = false;
 
@@ -41,9 +41,9 @@ public:
 						{
 							for (int i = 0; i < rect_circles.size(); i++)
 							{
-								if (getLen(rect_circles[i]->getPosition() - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
+								if (getLen(toVec(rect_circles[i]->getPosition()) - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
 								{
-									mouse_pos = rect_circles[i]->getPosition();
+									mouse_pos = toVec(rect_circles[i]->getPosition());
 									break;
 								}
 							}
@@ -112,9 +112,9 @@ public:
 						{
 							for (int i = 0; i < rect_circles.size(); i++)
 							{
-								if (getLen(rect_circles[i]->getPosition() - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
+								if (getLen(toVec(rect_circles[i]->getPosition()) - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
 								{
-									leftButtonPressedPos = rect_circles[i]->getPosition();
+									leftButtonPressedPos = toVec(rect_circles[i]->getPosition());
 									break;
 								}
 							}
@@ -177,9 +177,9 @@ public:
 
 	void update()
 	{
-		sf::Vector2f mouse_pos = conf::window.mapPixelToCoords(sf::Mouse::getPosition(conf::window));
+		Vec2f mouse_pos = toVec(conf::window.mapPixelToCoords(sf::Mouse::getPosition(conf::window)));
 		mouse_pos.y = conf::Y - mouse_pos.y;
-		sf::Vector2f temp = mouse_pos - leftButtonPressedPos;
+		Vec2f temp = mouse_pos - leftButtonPressedPos;
 
 
 		if (conf::mode == Mode::SPAWN)
@@ -190,12 +190,12 @@ public:
 				if (conf::spawnMode == SpawnMode::RECT)
 				{
 					RectangleObject rect = RectangleObject(leftButtonPressedPos, mouse_pos, conf::rectangle_thickness);
-					conf::window.draw(rect);
+					conf::window.draw(ObjectShape(rect));
 				}
 				else if (conf::spawnMode == SpawnMode::CIRCLE)
 				{
 					CircleObject circle = CircleObject(leftButtonPressedPos, getLen(temp));
-					conf::window.draw(circle);
+					conf::window.draw(ObjectShape(circle));
 				}
 				else if (conf::spawnMode == SpawnMode::POLYGON)
 				{
@@ -242,8 +242,8 @@ public:
 					if (sim.objects[i]->type != ObjectType::RECT)
 						continue;
 					RectangleObject* rect = (RectangleObject*)sim.objects[i];
-					sf::Vector2f vec1 = rect->vertices[1] - rect->vertices[0];
-					sf::Vector2f vec2 = rect->vertices[3] - rect->vertices[2];
+					Vec2f vec1 = rect->vertices[1] - rect->vertices[0];
+					Vec2f vec2 = rect->vertices[3] - rect->vertices[2];
 					vec1 /= getLen(vec1);
 					vec2 /= getLen(vec2);
 
@@ -252,10 +252,10 @@ public:
 						new sf::CircleShape(conf::polygonSpawnRadius / 1.3f, 9),
 						new sf::CircleShape(conf::polygonSpawnRadius / 1.3f, 9) };
 
-					circles[0]->setPosition(rect->vertices[0] + vec1 * conf::rectangle_thickness / 2.0f - rect->normals[0] * 0.05f);
-					circles[1]->setPosition(rect->vertices[1] - vec1 * conf::rectangle_thickness / 2.0f - rect->normals[0] * 0.05f);
-					circles[2]->setPosition(rect->vertices[2] + vec2 * conf::rectangle_thickness / 2.0f - rect->normals[2] * 0.05f);
-					circles[3]->setPosition(rect->vertices[3] - vec2 * conf::rectangle_thickness / 2.0f - rect->normals[2] * 0.05f);
+					circles[0]->setPosition(toSf(rect->vertices[0] + vec1 * conf::rectangle_thickness / 2.0f - rect->normals[0] * 0.05f));
+					circles[1]->setPosition(toSf(rect->vertices[1] - vec1 * conf::rectangle_thickness / 2.0f - rect->normals[0] * 0.05f));
+					circles[2]->setPosition(toSf(rect->vertices[2] + vec2 * conf::rectangle_thickness / 2.0f - rect->normals[2] * 0.05f));
+					circles[3]->setPosition(toSf(rect->vertices[3] - vec2 * conf::rectangle_thickness / 2.0f - rect->normals[2] * 0.05f));
 
 					for (int j = 0; j < 4; j++)
 					{
@@ -267,7 +267,7 @@ public:
 
 				for (int i = 0; i < rect_circles.size(); i++)
 				{
-					if (getLen(rect_circles[i]->getPosition() - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
+					if (getLen(toVec(rect_circles[i]->getPosition()) - mouse_pos) <= conf::polygonSpawnRadius / 1.3f)
 					{
 						rect_circles[i]->setScale(1.5f, 1.5f);
 					}
@@ -283,7 +283,7 @@ public:
 		{
 			if (drag_object != nullptr)
 			{
-				sf::Vector2f to_move = mouse_pos - prev_mouse_pos;
+				Vec2f to_move = mouse_pos - prev_mouse_pos;
 				drag_object->move(to_move);
 			}
 		}
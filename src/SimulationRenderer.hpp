@@ -0,0 +1,37 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "core/Simulation.hpp"
+#include "Conf.hpp"
+#include "Objects.hpp"
+#include "Util.hpp"
+
+class SimulationRenderer : public sf::Drawable
+{
+public:
+	const Simulation& sim;
+
+	SimulationRenderer(const Simulation& sim) : sim(sim) {}
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+	{
+		sf::CircleShape circle = conf::circle;
+		for (int i = 0; i < sim.particles.size(); i++)
+		{
+			circle.setPosition({ sim.particles.x[i], conf::Y - sim.particles.y[i] });
+			const sf::Color left = conf::COLOR_PARTICLE, right = sf::Color::White;
+			const float c = std::min(1.0f, getLen(sim.particles.velocity(i)) / 20.0f);
+			circle.setFillColor(sf::Color(
+				left.r + c * (right.r - left.r), 
+				left.g + c * (right.g - left.g),
+				left.b + c * (right.b - left.b),
+			 	left.a + c * (right.a - left.a)));
+			target.draw(circle);
+		}
+
+		const sf::Color object_color(conf::COLOR_OBJECT.r, conf::COLOR_OBJECT.g, conf::COLOR_OBJECT.b, 255);
+		for (CollisionObject* object : sim.objects)
+		{
+			target.draw(ObjectShape(*object, object_color));
+		}
+	}
+};
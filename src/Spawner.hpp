@@ -1,7 +1,6 @@
 #pragma once
-#include <SFML/Graphics.hpp>
-#include "Particle.hpp"
-#include "Simulation.hpp"
+#include "core/Particle.hpp"
+#include "core/Simulation.hpp"
 #include "Conf.hpp"
 #include "Util.hpp"
 
@@ -19,35 +18,38 @@ public:
 
 	void spawnLine(Particle p, float spaceBetween)
 	{
-		spawnParticle(p);
-		sf::Vector2f v = p.v, norm_v(v.y, -v.x);
+		std::vector<Particle> line;
+		line.push_back(p);
+		Vec2f v = p.v, norm_v(v.y, -v.x);
 		norm_v /= getLen(norm_v);
 
 		if (std::isnan(norm_v.x) || std::isinf(norm_v.x))
 		{
 			float angle = randFloat(0.0, 360.0) * conf::PI / 180;
-			norm_v = sf::Vector2f(cos(angle), sin(angle));
+			norm_v = Vec2f(cos(angle), sin(angle));
 		}
 
 		for (int i = 1; i <= (conf::particle_amount - 1) / 2; i++)
 		{
 			Particle left(p.pos + spaceBetween * norm_v * float(i));
 			left.v = p.v;
-			spawnParticle(left);
+			line.push_back(left);
 		}
 
 		for (int i = 1; i <= (conf::particle_amount - 1) / 2; i++)
 		{
 			Particle right(p.pos - spaceBetween * norm_v * float(i));
 			right.v = p.v;
-			spawnParticle(right);
+			line.push_back(right);
 		}
 
 		if ((conf::particle_amount - 1) % 2 == 1)
 		{
 			Particle left(p.pos + spaceBetween * norm_v * float((conf::particle_amount - 1) / 2 + 1));
 			left.v = p.v;
-			spawnParticle(left);
+			line.push_back(left);
 		}
+
+		sim.addParticles(line);
 	}
 };
\ No newline at end of file
@@ -3,14 +3,21 @@
 #include <SFML/Graphics.hpp>
 #include <sstream>
 #include <math.h>
+#include "core/Util.hpp"
 
 float getLen(sf::Vector2f vec)
 {
 	return sqrt(vec.x * vec.x + vec.y * vec.y);
 }
 
-float randFloat(float low, float high) {
-	return low + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (high - low)));
+sf::Vector2f toSf(Vec2f vec)
+{
+	return sf::Vector2f(vec.x, vec.y);
+}
+
+Vec2f toVec(sf::Vector2f vec)
+{
+	return Vec2f(vec.x, vec.y);
 }
 
 std::string to_string_with_precision(const float a_value, const int n = 6)
@@ -19,4 +26,4 @@ std::string to_string_with_precision(const float a_value, const int n = 6)
     out.precision(n);
     out << std::fixed << a_value;
     return std::move(out).str();
-}
\ No newline at end of file
+}
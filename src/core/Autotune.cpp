@@ -0,0 +1,202 @@
+#include "Autotune.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace autotune
+{
+	namespace
+	{
+		const int WARMUP_STEPS = 3;
+
+		std::vector<int> threadCandidates()
+		{
+			const int hardware = std::max(1u, std::thread::hardware_concurrency());
+			std::vector<int> candidates;
+			for (int threads = 1; threads < hardware; threads *= 2)
+				candidates.push_back(threads);
+			candidates.push_back(hardware);
+			return candidates;
+		}
+
+		//	Tries every value of one knob with the others fixed and keeps the fastest in best.
+		template <class T, class Set>
+		void tryValues(const Simulation& sim, int steps, Settings& best, float& best_time, const std::vector<T>& values, Set set)
+		{
+			for (const T& value : values)
+			{
+				Settings candidate = best;
+				set(candidate, value);
+				if (candidate.describe() == best.describe())
+					continue;
+				const float time = measure(sim, candidate, steps);
+				if (time < best_time)
+				{
+					best = candidate;
+					best_time = time;
+				}
+			}
+		}
+	}
+
+	std::string hostName()
+	{
+#if defined(_WIN32)
+		const char* name = std::getenv("COMPUTERNAME");
+		return name != nullptr ? name : "unknown";
+#else
+		char name[256] = {};
+		if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0')
+			return "unknown";
+		return name;
+#endif
+	}
+
+	int bucket(int particles)
+	{
+		int b = 0;
+		while (particles > 1)
+		{
+			particles >>= 1;
+			b++;
+		}
+		return b;
+	}
+
+	std::string cacheMode(const StepTuning& tuning)
+	{
+		std::ostringstream out;
+		out << "pairs=" << tuning.pair_list << ",skin=" << tuning.verlet_skin << ",compact=" << tuning.compact
+			<< ",jacobi=" << tuning.jacobi;
+		return out.str();
+	}
+
+	bool loadCached(const std::string& path, int bucket, const std::string& mode, Settings& settings)
+	{
+		std::ifstream in(path);
+		const std::string host = hostName();
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream entry(line);
+			std::string entry_host, entry_mode;
+			int entry_bucket, layout;
+			Settings read;
+			if (entry >> entry_host >> entry_bucket >> entry_mode >> read.threads >> read.tuning.spring_chunk >> read.tuning.spring_batch
+				>> read.tuning.colour_stride >> read.tuning.cell_scale >> layout && entry_host == host && entry_bucket == bucket
+				&& entry_mode == mode)
+			{
+				read.tuning.grid_layout = static_cast<GridLayout>(layout);
+				settings = read;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool storeCached(const std::string& path, int bucket, const std::string& mode, const Settings& settings)
+	{
+		const std::string host = hostName();
+		std::vector<std::string> lines;
+		{
+			std::ifstream in(path);
+			std::string line;
+			while (std::getline(in, line))
+			{
+				std::istringstream entry(line);
+				std::string entry_host, entry_mode;
+				int entry_bucket;
+				if (entry >> entry_host >> entry_bucket >> entry_mode && entry_host == host && entry_bucket == bucket
+					&& entry_mode == mode)
+					continue;
+				lines.push_back(line);
+			}
+		}
+
+		std::ofstream out(path);
+		for (const std::string& line : lines)
+			out << line << "\n";
+		out << host << " " << bucket << " " << mode << " " << settings.threads << " " << settings.tuning.spring_chunk << " "
+			<< settings.tuning.spring_batch << " " << settings.tuning.colour_stride << " " << settings.tuning.cell_scale << " "
+			<< static_cast<int>(settings.tuning.grid_layout) << "\n";
+		return static_cast<bool>(out);
+	}
+
+	float measure(const Simulation& sim, const Settings& settings, int steps)
+	{
+		parallel::setThreadCount(settings.threads);
+
+		Simulation trial(sim.config);
+		trial.setTuning(settings.tuning);
+		trial.objects = sim.objects;
+		const int PARTICLES_SIZE = (int)sim.particles.size();
+		for (int i = 0; i < PARTICLES_SIZE; i++)
+			trial.addParticle(sim.particles[i]);
+
+		for (int i = 0; i < WARMUP_STEPS; i++)
+			trial.update();
+		Clock clock;
+		for (int i = 0; i < steps; i++)
+			trial.update();
+		return clock.restart() / std::max(steps, 1);
+	}
+
+	Settings tune(const Simulation& sim, int steps)
+	{
+		Settings best;
+		best.threads = parallel::threadCount();
+		best.tuning = sim.tuning;
+		float best_time = measure(sim, best, steps);
+
+		tryValues(sim, steps, best, best_time, threadCandidates(), [](Settings& s, int v) { s.threads = v; });
+		tryValues(sim, steps, best, best_time, std::vector<GridLayout>{ GridLayout::NESTED, GridLayout::SORTED, GridLayout::HASHED },
+			[](Settings& s, GridLayout v) { s.tuning.grid_layout = v; });
+		tryValues(sim, steps, best, best_time, std::vector<float>{ 1.0f, 1.25f, 1.5f, 2.0f },
+			[](Settings& s, float v) { s.tuning.cell_scale = v; });
+		tryValues(sim, steps, best, best_time, std::vector<int>{ 3, 4 }, [](Settings& s, int v) { s.tuning.colour_stride = v; });
+		if (sim.featureMask() & features::SPRINGS)
+		{
+			tryValues(sim, steps, best, best_time, std::vector<int>{ 100, 200, 400, 800, 1600 },
+				[](Settings& s, int v) { s.tuning.spring_chunk = v; });
+			tryValues(sim, steps, best, best_time, std::vector<int>{ 100, 300, 600, StepTuning::MAX_SPRING_BATCH },
+				[](Settings& s, int v) { s.tuning.spring_batch = v; });
+		}
+
+		parallel::setThreadCount(best.threads);
+		return best;
+	}
+
+	Settings apply(Simulation& sim, const std::string& cache_path, bool retune, int steps, bool& from_cache)
+	{
+		const int particle_bucket = bucket(sim.particles.size());
+		const std::string mode = cacheMode(sim.tuning);
+		Settings settings;
+		from_cache = !retune && loadCached(cache_path, particle_bucket, mode, settings);
+		//	Reordering only pays off over long runs and the pair list, compact positions and Jacobi relaxation
+		//	change the physics, so they are left as the caller set them, like the tile order.
+		settings.tuning.reorder_interval = sim.tuning.reorder_interval;
+		settings.tuning.pair_list = sim.tuning.pair_list;
+		settings.tuning.verlet_skin = sim.tuning.verlet_skin;
+		settings.tuning.cost_order = sim.tuning.cost_order;
+		settings.tuning.compact = sim.tuning.compact;
+		settings.tuning.jacobi = sim.tuning.jacobi;
+		settings.tuning.jacobi_weight = sim.tuning.jacobi_weight;
+		if (!from_cache)
+		{
+			settings = tune(sim, steps);
+			storeCached(cache_path, particle_bucket, mode, settings);
+		}
+
+		parallel::setThreadCount(settings.threads);
+		sim.setTuning(settings.tuning);
+		return settings;
+	}
+}
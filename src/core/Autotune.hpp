@@ -0,0 +1,40 @@
+#pragma once
+#include "Simulation.hpp"
+#include <string>
+
+//	Picks the thread count and StepTuning that run the current scene fastest. Candidates are timed one
+//	knob at a time on short runs of a copy of the simulation, and the winner is cached per host and
+//	particle-count bucket so later runs can skip the search.
+namespace autotune
+{
+	struct Settings
+	{
+		int threads = 1;
+		StepTuning tuning;
+
+		std::string describe() const
+		{
+			return "threads=" + std::to_string(threads) + " " + tuning.describe();
+		}
+	};
+
+	std::string hostName();
+	//	Particle counts in [2^b, 2^(b+1)) share bucket b.
+	int bucket(int particles);
+
+	//	The flags a cache entry was tuned under, as one token. They change what is fastest, and the pair list
+	//	clamps cell_scale to at least 1 + verlet_skin, so entries only apply under the same flags.
+	std::string cacheMode(const StepTuning& tuning);
+
+	//	Entries are keyed by host, bucket and mode.
+	bool loadCached(const std::string& path, int bucket, const std::string& mode, Settings& settings);
+	bool storeCached(const std::string& path, int bucket, const std::string& mode, const Settings& settings);
+
+	//	Average microseconds per step of a copy of sim run with settings, after a few warm-up steps.
+	float measure(const Simulation& sim, const Settings& settings, int steps);
+	Settings tune(const Simulation& sim, int steps);
+
+	//	Uses the cached settings for this host and particle count unless there are none or retune is set,
+	//	then applies them to sim and the parallel backend.
+	Settings apply(Simulation& sim, const std::string& cache_path, bool retune, int steps, bool& from_cache);
+}
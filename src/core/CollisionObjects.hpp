@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Particle.hpp"
+#include "Kernels.hpp"
+#include "Util.hpp"
+#include "Vector2.hpp"
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+enum class ObjectType
+{
+	CIRCLE = 0,
+	RECT = 1,
+	POLYGON = 2
+};
+
+class CollisionObject
+{
+public:
+	ObjectType type;
+	virtual ~CollisionObject() {}
+	virtual bool isColliding(const Particle& p) const = 0;
+	virtual void move(Vec2f to_move) = 0;
+	//	Geometry handed to the collide/stick kernels, valid until the object changes.
+	virtual ObjectView view() const = 0;
+};
+
+class PolygonObject : public CollisionObject
+{
+public:
+	std::vector<Vec2f> vertices;
+	std::vector<Vec2f> normals;
+	Vec2f min, max;
+
+	PolygonObject()
+	{
+		type = ObjectType::POLYGON;
+	}
+
+	void initiateVertices(std::vector<Vec2f> vertices_)
+	{
+		vertices = vertices_;
+
+		for (int i = 0; i < vertices.size(); i++)
+		{
+			min.x = std::min(min.x, vertices_[i].x);
+			min.y = std::min(min.y, vertices_[i].y);
+			max.x = std::max(max.x, vertices_[i].x);
+			max.y = std::max(max.y, vertices_[i].y);
+		}
+
+		calculateNormals();
+	}
+
+	void calculateNormals()
+	{
+		normals.resize(vertices.size());
+		for (int i = 1; i < vertices.size(); i++)
+		{
+			Vec2f temp = vertices[i] - vertices[i - 1];
+			normals[i - 1] = Vec2f(-temp.y, temp.x);
+		}
+		Vec2f temp = vertices[0] - vertices.back();
+		normals.back() = Vec2f(-temp.y, temp.x);
+
+		for (int i = 0; i < normals.size(); i++)
+			normals[i] /= getLen(normals[i]);
+	}
+
+	bool isColliding(const Particle& p) const override
+	{
+		if (p.pos.x < min.x || p.pos.y < min.y || p.pos.x > max.x || p.pos.y > max.y)
+			return false;
+		const Vec2f position = p.pos;
+
+		bool all_positive = true, all_negative = true;
+		for (int i = 0; i < vertices.size(); i++)
+		{
+			const Vec2f vert_to_point = position - vertices[i];
+			const float dot = vert_to_point.x * normals[i].x + vert_to_point.y * normals[i].y;
+			all_positive &= (dot >= 0);
+			all_negative &= (dot <= 0);
+			if (!all_positive && !all_negative)
+				return false;
+		}
+		return true;
+	}
+
+
+
+	ObjectView view() const override
+	{
+		ObjectView v = {};
+		v.shape = ObjectShapeType::POLYGON;
+		v.vertices = vertices.data();
+		v.normals = normals.data();
+		v.vertex_count = vertices.size();
+		v.min = min;
+		v.max = max;
+		return v;
+	}
+
+	void move(Vec2f to_move) override
+	{
+		for (int i = 0; i < vertices.size(); i++)
+		{
+			vertices[i] += to_move;
+		}
+		initiateVertices(vertices);
+	}
+};
+
+class RectangleObject : public PolygonObject
+{
+public:
+	RectangleObject(Vec2f start, Vec2f end, float thickness)
+	{
+		type = ObjectType::RECT;
+		Vec2f p = end - start;
+		Vec2f p_n(-p.y, p.x);
+		p_n = p_n / getLen(p_n) * thickness / 2.0f;
+
+		initiateVertices(std::vector<Vec2f>{ start + p_n, end + p_n, end - p_n, start - p_n });
+	}
+};
+
+class CircleObject : public CollisionObject
+{
+public:
+	Vec2f position;
+	float radius;
+
+	CircleObject(Vec2f position, float radius) : position(position), radius(radius)
+	{
+		type = ObjectType::CIRCLE;
+	}
+
+	bool isColliding(const Particle& p) const override
+	{
+		return getLen(p.pos - position) <= radius;
+	}
+
+	void move(Vec2f to_move) override
+	{
+		position += to_move;
+	}
+
+	ObjectView view() const override
+	{
+		ObjectView v = {};
+		v.shape = ObjectShapeType::CIRCLE;
+		v.position = position;
+		v.radius = radius;
+		return v;
+	}
+};
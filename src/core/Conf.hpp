@@ -0,0 +1,10 @@
+#pragma once
+
+//	Physical constants shared by every simulation. Tunable parameters live in SimulationConfig.
+namespace conf
+{
+	inline const float G = 9.81f;
+	inline const float PI = 3.1415;
+
+	inline const int START_MAX_PARTICLE_AMOUNT = 10000;
+}
@@ -0,0 +1,181 @@
+#include "CpuDispatch.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#if defined(FLUID_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kernels_generic { extern const KernelTable table; }
+#if defined(FLUID_KERNELS_X86)
+namespace kernels_sse42 { extern const KernelTable table; }
+namespace kernels_avx2 { extern const KernelTable table; }
+namespace kernels_avx512 { extern const KernelTable table; }
+#endif
+
+namespace cpu
+{
+	namespace
+	{
+		const char* const ISA_NAMES[] = { "generic", "sse4.2", "avx2", "avx512" };
+
+		const KernelTable* tableFor(Isa isa)
+		{
+			switch (isa)
+			{
+#if defined(FLUID_KERNELS_X86)
+			case Isa::SSE42: return &kernels_sse42::table;
+			case Isa::AVX2: return &kernels_avx2::table;
+			case Isa::AVX512: return &kernels_avx512::table;
+#endif
+			case Isa::GENERIC: return &kernels_generic::table;
+			default: return nullptr;
+			}
+		}
+
+		bool cpuHas(Isa isa)
+		{
+#if !defined(FLUID_KERNELS_X86)
+			return isa == Isa::GENERIC;
+#elif defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			const int max_leaf = info[0];
+			__cpuid(info, 1);
+			const bool sse42 = (info[2] & (1 << 20)) != 0, fma = (info[2] & (1 << 12)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+			const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+			const bool ymm_state = (xcr0 & 0x6) == 0x6, zmm_state = (xcr0 & 0xe6) == 0xe6;
+			int leaf7 = 0;
+			if (max_leaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				leaf7 = info[1];
+			}
+			const bool avx2 = (leaf7 & (1 << 5)) != 0;
+			const bool avx512 = (leaf7 & (1 << 16)) && (leaf7 & (1 << 17)) && (leaf7 & (1 << 30)) && (leaf7 & (1u << 31));
+
+			switch (isa)
+			{
+			case Isa::GENERIC: return true;
+			case Isa::SSE42: return sse42;
+			case Isa::AVX2: return avx && ymm_state && avx2 && fma;
+			case Isa::AVX512: return avx && zmm_state && avx2 && fma && avx512;
+			}
+			return false;
+#else
+			__builtin_cpu_init();
+			switch (isa)
+			{
+			case Isa::GENERIC: return true;
+			case Isa::SSE42: return __builtin_cpu_supports("sse4.2");
+			case Isa::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			case Isa::AVX512: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+				&& __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+				&& __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+			}
+			return false;
+#endif
+		}
+
+		Isa initialIsa()
+		{
+			const char* requested = std::getenv("FLUID_ISA");
+			Isa isa;
+			if (requested != nullptr && *requested != '\0')
+			{
+				if (parseIsa(requested, isa) && isaSupported(isa))
+					return isa;
+				std::cerr << "FLUID_ISA=" << requested << " is not available here, using " << isaName(bestIsa()) << "\n";
+			}
+			return bestIsa();
+		}
+
+		Isa& active()
+		{
+			static Isa isa = initialIsa();
+			return isa;
+		}
+	}
+
+	const char* isaName(Isa isa)
+	{
+		return ISA_NAMES[static_cast<int>(isa)];
+	}
+
+	bool parseIsa(const std::string& name, Isa& isa)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			if (name == ISA_NAMES[i])
+			{
+				isa = static_cast<Isa>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool isaCompiled(Isa isa)
+	{
+		return tableFor(isa) != nullptr;
+	}
+
+	bool isaSupported(Isa isa)
+	{
+		static const bool supported[] = {
+			isaCompiled(Isa::GENERIC) && cpuHas(Isa::GENERIC), isaCompiled(Isa::SSE42) && cpuHas(Isa::SSE42),
+			isaCompiled(Isa::AVX2) && cpuHas(Isa::AVX2), isaCompiled(Isa::AVX512) && cpuHas(Isa::AVX512)
+		};
+		return supported[static_cast<int>(isa)];
+	}
+
+	Isa bestIsa()
+	{
+		for (int i = 3; i > 0; i--)
+		{
+			if (isaSupported(static_cast<Isa>(i)))
+				return static_cast<Isa>(i);
+		}
+		return Isa::GENERIC;
+	}
+
+	Isa activeIsa()
+	{
+		return active();
+	}
+
+	bool selectIsa(Isa isa)
+	{
+		if (!isaSupported(isa))
+			return false;
+		active() = isa;
+		return true;
+	}
+
+	const KernelTable& kernels()
+	{
+		return *tableFor(active());
+	}
+
+	std::string report()
+	{
+		std::string compiled;
+		for (int i = 0; i < 4; i++)
+		{
+			if (isaCompiled(static_cast<Isa>(i)))
+				compiled += (compiled.empty() ? "" : " ") + std::string(ISA_NAMES[i]);
+		}
+		return std::string("kernels: ") + isaName(activeIsa()) + " (best supported: " + isaName(bestIsa())
+			+ ", compiled: " + compiled + ")";
+	}
+
+	int* scratchKeys(int count)
+	{
+		thread_local std::vector<int> keys;
+		if ((int)keys.size() < count)
+			keys.resize(count);
+		return keys.data();
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Kernels.hpp"
+#include <string>
+
+//	Instruction set levels the kernels are built for, from oldest to newest.
+enum class Isa
+{
+	GENERIC = 0,
+	SSE42 = 1,
+	AVX2 = 2,
+	AVX512 = 3
+};
+
+//	Picks the kernel variant at startup: the best one the CPU supports, unless the FLUID_ISA
+//	environment variable or selectIsa() asks for another.
+namespace cpu
+{
+	const char* isaName(Isa isa);
+	bool parseIsa(const std::string& name, Isa& isa);
+
+	//	Built into this binary (only the generic variant on non-x86 targets).
+	bool isaCompiled(Isa isa);
+	//	Built into this binary and usable on this CPU and OS.
+	bool isaSupported(Isa isa);
+	Isa bestIsa();
+
+	Isa activeIsa();
+	//	Switches every simulation to isa, returns false and keeps the current variant if it is not supported.
+	bool selectIsa(Isa isa);
+	const KernelTable& kernels();
+
+	//	One line naming the active, best and compiled variants.
+	std::string report();
+
+	//	Scratch space for the kernels: at least count ints, owned by the calling thread, only ever grown and
+	//	freed when the thread exits. Defined here so the std::vector code is built without the kernels' -m flags.
+	int* scratchKeys(int count);
+}
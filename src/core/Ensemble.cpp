@@ -0,0 +1,222 @@
+#include "Ensemble.hpp"
+#include "Scenes.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace ensemble
+{
+	bool parseAxis(const std::string& spec, Axis& axis)
+	{
+		const size_t eq = spec.find('=');
+		if (eq == std::string::npos)
+			return false;
+		axis.name = spec.substr(0, eq);
+		axis.values.clear();
+		SimulationConfig probe;
+		if (probe.parameter(axis.name) == nullptr)
+			return false;
+
+		const std::string list = spec.substr(eq + 1);
+		float from, to, step;
+		char colon1, colon2;
+		std::istringstream range(list);
+		if (range >> from >> colon1 >> to >> colon2 >> step && colon1 == ':' && colon2 == ':' && range.eof())
+		{
+			if (step <= 0 || to < from)
+				return false;
+			const int count = static_cast<int>(std::floor((to - from) / step + 1e-4f)) + 1;
+			for (int i = 0; i < count; i++)
+				axis.values.push_back(from + i * step);
+			return true;
+		}
+
+		std::istringstream values(list);
+		std::string value;
+		while (std::getline(values, value, ','))
+		{
+			char* end;
+			const float parsed = std::strtof(value.c_str(), &end);
+			if (value.empty() || *end != '\0')
+				return false;
+			axis.values.push_back(parsed);
+		}
+		return !axis.values.empty();
+	}
+
+	int runCount(const std::vector<Axis>& axes)
+	{
+		int count = 1;
+		for (const Axis& axis : axes)
+			count *= axis.values.size();
+		return count;
+	}
+
+	SimulationConfig runConfig(const Options& options, int index, std::vector<float>& values)
+	{
+		SimulationConfig config = options.base;
+		values.assign(options.axes.size(), 0.0f);
+		for (int a = options.axes.size() - 1; a >= 0; a--)
+		{
+			const Axis& axis = options.axes[a];
+			values[a] = axis.values[index % axis.values.size()];
+			index /= axis.values.size();
+			*config.parameter(axis.name) = values[a];
+		}
+		return config;
+	}
+
+	float densityError(const Simulation& sim)
+	{
+		const SimulationConfig& config = sim.config;
+		const float h2 = config.h * config.h, inv_h = 1.0f / config.h;
+		const int N = sim.particles.size();
+		if (N == 0)
+			return 0.0f;
+
+		double error = 0.0;
+		for (int i = 0; i < N; i++)
+		{
+			const Vec2f pos = sim.particles.pos(i);
+			const Vec2i tile = sim.grid.getKeyTile(i);
+			const TileView view = sim.grid.tileView(tile.y, tile.x);
+			float density = 0.0f;
+			for (int cell = 0; cell < view.neighbour_count; cell++)
+			{
+				for (int n = 0; n < view.neighbours[cell].count; n++)
+				{
+					const int j = view.neighbours[cell].keys[n];
+					if (j == i)
+						continue;
+					const Vec2f r = sim.particles.pos(j) - pos;
+					const float r2 = r.x * r.x + r.y * r.y;
+					if (r2 < h2)
+					{
+						const float q = std::sqrt(r2) * inv_h;
+						density += (1 - q) * (1 - q);
+					}
+				}
+			}
+			error += std::fabs(density - config.density_rest);
+		}
+		return error / N / config.density_rest;
+	}
+
+	float maxVelocity(const Simulation& sim)
+	{
+		float max_v2 = 0.0f;
+		const int PARTICLES_SIZE = (int)sim.particles.size();
+		for (int i = 0; i < PARTICLES_SIZE; i++)
+		{
+			const float v2 = sim.particles.vx[i] * sim.particles.vx[i] + sim.particles.vy[i] * sim.particles.vy[i];
+			//	Keeps a NaN so blown-up runs stand out in the table.
+			if (!(v2 <= max_v2))
+				max_v2 = v2;
+		}
+		return std::sqrt(max_v2);
+	}
+
+	namespace
+	{
+		bool hasSprings(const SimulationConfig& config)
+		{
+			return config.k_spring != 0.0f;
+		}
+	}
+
+	int springRunCount(const Options& options)
+	{
+		const int RUNS = runCount(options.axes);
+		std::vector<float> values;
+		int count = 0;
+		for (int index = 0; index < RUNS; index++)
+			count += hasSprings(runConfig(options, index, values));
+		return count;
+	}
+
+	int springConcurrency(const Options& options, size_t& table_bytes)
+	{
+		//	The table only depends on the particle capacity, which the scene decides.
+		Simulation probe(options.base);
+		scenes::load(probe, options.scene);
+		for (CollisionObject* object : probe.objects)
+			delete object;
+		const size_t capacity = probe.springs.maxParticleAmount;
+		table_bytes = ParticleSprings::tableBytes(capacity);
+		if (!ParticleSprings::fits(capacity))
+			return 0;
+		return (int)std::max<size_t>(options.spring_memory / table_bytes, 1);
+	}
+
+	bool run(const Options& options, std::vector<RunResult>& results)
+	{
+		{
+			Simulation probe(options.base);
+			if (!scenes::load(probe, options.scene))
+				return false;
+			for (CollisionObject* object : probe.objects)
+				delete object;
+		}
+
+		const int RUNS = runCount(options.axes);
+		results.assign(RUNS, RunResult());
+
+		std::vector<int> plain, sprung;
+		std::vector<float> values;
+		for (int index = 0; index < RUNS; index++)
+			(hasSprings(runConfig(options, index, values)) ? sprung : plain).push_back(index);
+
+		auto runOne = [&](int index) {
+			RunResult& result = results[index];
+			Simulation sim(runConfig(options, index, result.values));
+			sim.setTuning(options.tuning);
+			scenes::load(sim, options.scene);
+
+			for (int i = 0; i < options.warmup; i++)
+				sim.update();
+
+			Clock clock;
+			for (int i = 0; i < options.steps; i++)
+				sim.update();
+			const float seconds = clock.restart() / 1e6f;
+
+			result.particles = sim.particles.size();
+			result.steps_per_second = seconds > 0 ? options.steps / seconds : 0.0f;
+			result.density_error = densityError(sim);
+			result.max_velocity = maxVelocity(sim);
+
+			for (CollisionObject* object : sim.objects)
+				delete object;
+		};
+
+		parallel::forEach((int)plain.size(), 1, [&](int k) { runOne(plain[k]); });
+		//	Every run with springs holds its table until it finishes, so they go in groups that fit spring_memory.
+		//	Runs whose table does not fit at all step without springs and need no limit.
+		size_t table_bytes;
+		const int concurrency = springConcurrency(options, table_bytes);
+		const int GROUP = concurrency > 0 ? concurrency : std::max((int)sprung.size(), 1);
+		const int SPRUNG_SIZE = (int)sprung.size();
+		for (int first = 0; first < SPRUNG_SIZE; first += GROUP)
+		{
+			parallel::forEach(std::min(GROUP, SPRUNG_SIZE - first), 1, [&](int k) { runOne(sprung[first + k]); });
+		}
+		return true;
+	}
+
+	void writeTable(std::ostream& out, const Options& options, const std::vector<RunResult>& results)
+	{
+		for (const Axis& axis : options.axes)
+			out << axis.name << ",";
+		out << "particles,steps_per_sec,density_error,max_velocity\n";
+
+		for (const RunResult& result : results)
+		{
+			for (const float value : result.values)
+				out << value << ",";
+			out << result.particles << "," << result.steps_per_second << "," << result.density_error << ","
+				<< result.max_velocity << "\n";
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Simulation.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+
+//	Runs one scene under every combination of a parameter grid, one headless Simulation per combination,
+//	spread over the parallel backend's threads. Each run is single threaded.
+namespace ensemble
+{
+	//	One swept SimulationConfig parameter.
+	struct Axis
+	{
+		std::string name;
+		std::vector<float> values;
+	};
+
+	struct Options
+	{
+		std::string scene = "block";
+		int steps = 1000, warmup = 0;
+		SimulationConfig base;
+		//	Applied to every run, so the sweep measures the same mode as a single run with these flags.
+		StepTuning tuning;
+		std::vector<Axis> axes;
+		//	Runs with springs each allocate a dense spring table, 400 MB for up to 10000 particles. At most
+		//	this many bytes of tables are live at once, see springConcurrency.
+		size_t spring_memory = size_t(2) << 30;
+	};
+
+	struct RunResult
+	{
+		std::vector<float> values;		//	one per axis
+		int particles = 0;
+		float steps_per_second = 0;
+		float density_error = 0;		//	mean |density - density_rest| / density_rest after the last step
+		float max_velocity = 0;
+	};
+
+	//	Parses "name=v1,v2,..." or "name=from:to:step". Returns false if the name is not a config
+	//	parameter or no value could be read.
+	bool parseAxis(const std::string& spec, Axis& axis);
+
+	int runCount(const std::vector<Axis>& axes);
+	//	The config of run index, the last axis varying fastest.
+	SimulationConfig runConfig(const Options& options, int index, std::vector<float>& values);
+
+	//	Runs whose config enables springs, see Simulation::featureMask.
+	int springRunCount(const Options& options);
+	//	How many runs with springs run() keeps in flight at once, and the spring table each of them allocates
+	//	for the scene. 0 if its table is over ParticleSprings::MAX_TABLE_BYTES, in which case those runs step
+	//	without springs.
+	int springConcurrency(const Options& options, size_t& table_bytes);
+
+	//	Runs every combination, the ones with springs at most springConcurrency at a time. Returns false if
+	//	the scene does not exist.
+	bool run(const Options& options, std::vector<RunResult>& results);
+
+	//	Same density estimate as doubleDensityRelaxation, averaged over the particles.
+	float densityError(const Simulation& sim);
+	float maxVelocity(const Simulation& sim);
+
+	//	Writes the results as CSV, one row per run.
+	void writeTable(std::ostream& out, const Options& options, const std::vector<RunResult>& results);
+}
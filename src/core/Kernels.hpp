@@ -0,0 +1,180 @@
+#pragma once
+#include <cstdint>
+#include "Particle.hpp"
+#include "SimulationConfig.hpp"
+#include "Vector2.hpp"
+
+//	Plain views of simulation state handed to the hot kernels. The kernels are compiled once per
+//	instruction set (see kernels/KernelsImpl.inl), so everything they see has to be plain data.
+
+//	Particle state as separate arrays, see ParticleStore. px, py is the position before prediction.
+struct ParticleView
+{
+	float* x;
+	float* y;
+	float* px;
+	float* py;
+	float* vx;
+	float* vy;
+};
+
+struct CellSpan
+{
+	const int* keys;
+	int count;
+};
+
+//	One grid tile and the cells of its 3x3 neighbourhood (the tile itself included).
+struct TileView
+{
+	CellSpan own;
+	CellSpan neighbours[9];
+	int neighbour_count;
+};
+
+//	One grid tile and the forward half of its neighbourhood: the existing cells among (i, j + 1) and
+//	(i + 1, j - 1 .. j + 1). Pairs inside the tile are taken by their lower index and pairs with a forward
+//	cell always, so a pass over every tile meets each unordered pair of nearby particles exactly once.
+struct HalfTileView
+{
+	CellSpan own;
+	CellSpan forward[4];
+	int forward_count;
+};
+
+//	Cells of margin around each cell that its 16-bit positions can still reach, see CompactPositions.
+constexpr int COMPACT_MARGIN = 4;
+
+//	Positions as 16-bit offsets for the compact relaxation mode. The particles of each cell sit in consecutive
+//	slots, in the order of the grid's index array, and value q of a particle stands for origin + q * step,
+//	with the origin COMPACT_MARGIN cells below and left of its cell. The margin keeps particles that have
+//	left their cell since the grid was built representable.
+struct CompactPositions
+{
+	uint16_t* x;
+	uint16_t* y;
+	float step_x, step_y;
+	float inv_step_x, inv_step_y;
+};
+
+//	Slots [begin, begin + count) of one cell and the position its value 0 stands for.
+struct CompactSpan
+{
+	int begin, count;
+	float origin_x, origin_y;
+};
+
+//	The helpers below are static so each kernel variant compiles its own copy, see kernels/KernelsImpl.inl.
+
+//	Value of position relative to origin, rounded to the nearest step and saturated at 0 and 65535.
+static inline uint16_t encodeCompact(float position, float origin, float inv_step)
+{
+	const float q = (position - origin) * inv_step + 0.5f;
+	return (uint16_t)(q <= 0.0f ? 0.0f : q >= 65535.0f ? 65535.0f : q);
+}
+
+//	Whether encodeCompact(position, origin, inv_step) only rounds, without saturating.
+static inline bool compactFits(float position, float origin, float inv_step)
+{
+	const float q = (position - origin) * inv_step + 0.5f;
+	return q >= 0.0f && q < 65536.0f;
+}
+
+static inline float decodeCompact(uint16_t q, float origin, float step)
+{
+	return origin + q * step;
+}
+
+//	TileView over compact slots.
+struct CompactTileView
+{
+	CompactSpan own;
+	CompactSpan neighbours[9];
+	int neighbour_count;
+};
+
+//	Neighbour j of some particle i as of the last NeighbourList build or refresh: |r_ij| = q * h, unit points
+//	from i to j. Lists built with a skin also hold candidates with q >= 1.
+struct NeighbourPair
+{
+	int j;
+	float q;
+	Vec2f unit;
+};
+
+//	The neighbours of particle i are pairs[start[i], start[i + 1]).
+struct PairView
+{
+	const int* start;
+	const NeighbourPair* pairs;
+};
+
+enum class ObjectShapeType
+{
+	CIRCLE = 0,
+	POLYGON = 1
+};
+
+struct ObjectView
+{
+	ObjectShapeType shape;
+	Vec2f position;									//	circle centre
+	float radius;
+	const Vec2f* vertices;							//	polygon outline and outward normals
+	const Vec2f* normals;
+	int vertex_count;
+	Vec2f min, max;
+};
+
+//	What integrateEnd needs besides the particles. Unbounded worlds pass infinite bounds.
+struct IntegrationBox
+{
+	float min_x, min_y, max_x, max_y;
+	float cell_w, cell_h;					//	grid cell size
+};
+
+struct KernelTable
+{
+	const char* name;
+
+	//	Double density relaxation for every particle of tile.own.
+	void (*densityTile)(const ParticleView& particles, const TileView& tile, const StepConstants& c);
+	//	densityTile on compact positions, decoding and re-encoding each value as it is used.
+	void (*densityCompact)(const CompactPositions& positions, const CompactTileView& tile, const StepConstants& c);
+	//	Jacobi relaxation, first pass: density pressure and near pressure of every particle of tile.own.
+	void (*densityPressure)(const ParticleView& particles, const TileView& tile, const StepConstants& c,
+		float* pressure_out, float* pressure_near_out);
+	//	Jacobi relaxation, second pass: the relaxed position of every particle of tile.own, gathered from the
+	//	pressures of both sides of each pair, scaled by weight and written to x_out, y_out. Only reads particles.
+	void (*densityGather)(const ParticleView& particles, const TileView& tile, const float* pressure,
+		const float* pressure_near, float weight, const StepConstants& c, float* x_out, float* y_out);
+	//	Radial viscosity impulses between the pairs of tile's half stencil.
+	void (*viscosityTile)(const ParticleView& particles, const HalfTileView& tile, const StepConstants& c);
+	//	densityTile over the cached neighbours of the own particles instead of the 3x3 cells. Distances are
+	//	recomputed, since relaxation moves the particles it has already visited.
+	void (*densityPairs)(const ParticleView& particles, CellSpan own, const PairView& pairs, const StepConstants& c);
+	//	Viscosity of particles [begin, end) over the cached pairs, using their q and unit vector. Each particle
+	//	sums the impulses of its own row, computed from the velocities before the pass, and writes only its new
+	//	velocity, to vx_out, vy_out, and its position, moved by the impulses * dt since this runs after
+	//	prediction. So ranges can run in parallel without colouring.
+	void (*viscosityPairs)(const ParticleView& particles, int begin, int end, const PairView& pairs, const StepConstants& c,
+		float* vx_out, float* vy_out);
+	//	Plastic rest length update for count springs, written to lengths_out.
+	void (*springLengths)(const ParticleView& particles, const int* keys, const float* rest_lengths, int count, int stride,
+		const StepConstants& c, float* lengths_out);
+	//	Half of the spring displacement for count springs, written to displacements_out.
+	void (*springDisplacements)(const ParticleView& particles, const int* keys, const float* rest_lengths, int count, int stride,
+		const StepConstants& c, Vec2f* displacements_out);
+	//	Gravity and prediction for particles [begin, end): vy += dv_y, the position is saved as the previous one
+	//	and advanced by v * dt.
+	void (*integrateBegin)(const ParticleView& particles, int begin, int end, float dv_y, float dt);
+	//	The end of the step for particles [begin, end): clamps the positions into the box (a clamped component
+	//	also becomes the previous one, so that velocity component is 0), sets v = (pos - prev) * inv_dt and
+	//	writes the grid cell of each particle to tiles_out, as ParticleGrid::getTile would.
+	void (*integrateEnd)(const ParticleView& particles, int begin, int end, const IntegrationBox& box, float inv_dt,
+		Vec2i* tiles_out);
+	//	Pushes particles [begin, end) out of the objects.
+	void (*collide)(const ParticleView& particles, int begin, int end, const ObjectView* objects, int object_count);
+	//	Pulls particles [begin, end) towards nearby object surfaces.
+	void (*stick)(const ParticleView& particles, int begin, int end, const ObjectView* objects, int object_count, const StepConstants& c);
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Kernels.hpp"
+#include "Parallel.hpp"
+#include "ParticleGrid.hpp"
+
+//	Every particle's neighbours within a cutoff, found with one walk of the 3x3 cell stencil and kept in
+//	compressed rows so the phases of a step can share them instead of walking the grid again. With a
+//	cutoff of h + skin the list stays complete, and can be reused with refresh(), until some particle
+//	has moved more than skin / 2 from where it was at the build.
+class NeighbourList
+{
+public:
+	std::vector<int> start;
+	std::vector<NeighbourPair> pairs;
+	//	Positions at the last build.
+	std::vector<Vec2f> reference;
+	float cutoff = 0.0f;
+	bool valid = false;
+
+	void invalidate()
+	{
+		valid = false;
+	}
+
+	PairView view() const
+	{
+		return { start.data(), pairs.data() };
+	}
+
+	int pairCount() const
+	{
+		return pairs.size();
+	}
+
+	//	Called by every member of team. The grid must hold every particle and its cells must be at least
+	//	cutoff wide. q is stored in units of h, so entries beyond h have q >= 1.
+	void build(parallel::Team& team, const ParticleStore& particles, const ParticleGrid& grid, float h, float cutoff)
+	{
+		const int count = particles.size();
+		const float cutoff2 = cutoff * cutoff, inv_h = 1.0f / h;
+		const int CHUNKS = (count + BUILD_CHUNK_SIZE - 1) / BUILD_CHUNK_SIZE;
+
+		team.single([&] {
+			start.resize(count + 1);
+			start[0] = 0;
+			if ((int)chunk_pairs.size() < CHUNKS)
+				chunk_pairs.resize(CHUNKS);
+			reference.resize(count);
+		});
+
+		team.forRange(count, BUILD_CHUNK_SIZE, [&](int begin, int end) {
+			std::vector<NeighbourPair>& out = chunk_pairs[begin / BUILD_CHUNK_SIZE];
+			out.clear();
+			for (int i = begin; i < end; i++)
+			{
+				const Vec2f pos = particles.pos(i);
+				reference[i] = pos;
+				const Vec2i tile = grid.getKeyTile(i);
+				const TileView view = grid.tileView(tile.y, tile.x);
+				const int before = out.size();
+				for (int cell = 0; cell < view.neighbour_count; cell++)
+				{
+					const CellSpan span = view.neighbours[cell];
+					for (int n = 0; n < span.count; n++)
+					{
+						const int j = span.keys[n];
+						if (j == i)
+							continue;
+						const float rx = particles.x[j] - pos.x, ry = particles.y[j] - pos.y;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 >= cutoff2)
+							continue;
+						const float r = std::sqrt(r2);
+						NeighbourPair pair;
+						pair.j = j;
+						pair.q = r * inv_h;
+						pair.unit = r > 0.0f ? Vec2f(rx / r, ry / r) : Vec2f(0.0f, 0.0f);
+						out.push_back(pair);
+					}
+				}
+				start[i + 1] = out.size() - before;
+			}
+		});
+
+		team.single([&] {
+			for (int i = 0; i < count; i++)
+				start[i + 1] += start[i];
+			pairs.resize(start[count]);
+		});
+
+		team.forRange(count, BUILD_CHUNK_SIZE, [&](int begin, int) {
+			const std::vector<NeighbourPair>& chunk = chunk_pairs[begin / BUILD_CHUNK_SIZE];
+			std::copy(chunk.begin(), chunk.end(), pairs.begin() + start[begin]);
+		});
+
+		//	Last, so every member has read valid before it changes.
+		team.single([&] {
+			this->cutoff = cutoff;
+			valid = true;
+		});
+	}
+
+	//	Largest distance any particle has moved since the build. Every member gets the same value.
+	float maxDisplacement(parallel::Team& team, const ParticleStore& particles)
+	{
+		const int count = particles.size();
+		const int CHUNKS = (count + BUILD_CHUNK_SIZE - 1) / BUILD_CHUNK_SIZE;
+		team.single([&] { chunk_max.assign(CHUNKS, 0.0f); });
+
+		team.forRange(count, BUILD_CHUNK_SIZE, [&](int begin, int end) {
+			float max_d2 = 0.0f;
+			for (int i = begin; i < end; i++)
+			{
+				const float dx = particles.x[i] - reference[i].x, dy = particles.y[i] - reference[i].y;
+				max_d2 = std::max(max_d2, dx * dx + dy * dy);
+			}
+			chunk_max[begin / BUILD_CHUNK_SIZE] = max_d2;
+		});
+
+		float max_d2 = 0.0f;
+		for (const float d2 : chunk_max)
+			max_d2 = std::max(max_d2, d2);
+		//	Nobody may resize chunk_max for the next call before everyone has read it.
+		team.barrier();
+		return std::sqrt(max_d2);
+	}
+
+	//	Recomputes q and the unit vector of every pair from the current positions.
+	void refresh(parallel::Team& team, const ParticleStore& particles, float h)
+	{
+		const int count = particles.size();
+		const float inv_h = 1.0f / h;
+		team.forRange(count, BUILD_CHUNK_SIZE, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				const Vec2f pos = particles.pos(i);
+				for (int n = start[i]; n < start[i + 1]; n++)
+				{
+					NeighbourPair& pair = pairs[n];
+					const float rx = particles.x[pair.j] - pos.x, ry = particles.y[pair.j] - pos.y;
+					const float r = std::sqrt(rx * rx + ry * ry);
+					pair.q = r * inv_h;
+					pair.unit = r > 0.0f ? Vec2f(rx / r, ry / r) : Vec2f(0.0f, 0.0f);
+				}
+			}
+		});
+	}
+
+private:
+	static constexpr int BUILD_CHUNK_SIZE = 512;
+
+	std::vector<std::vector<NeighbourPair>> chunk_pairs;
+	std::vector<float> chunk_max;
+};
@@ -0,0 +1,349 @@
+#include "Parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(FLUID_USE_OPENMP)
+#include <omp.h>
+#endif
+
+namespace parallel
+{
+	namespace
+	{
+		//	Set on pool workers and on the caller while it runs chunks, so nested loops run inline.
+		thread_local bool inside_run = false;
+
+		int hardwareThreads()
+		{
+			const unsigned int count = std::thread::hardware_concurrency();
+			return count == 0 ? 1 : count;
+		}
+
+		class ThreadPool
+		{
+		public:
+			explicit ThreadPool(int size) : queues(size)
+			{
+				for (int i = 1; i < size; i++)
+					workers.emplace_back(&ThreadPool::workerLoop, this, i);
+			}
+
+			~ThreadPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m);
+					stopping = true;
+				}
+				wake.notify_all();
+				for (std::thread& worker : workers)
+					worker.join();
+			}
+
+			//	Returns false without running anything if another thread is using the pool. Without stealing
+			//	each worker only runs the chunks it was dealt, which region() relies on.
+			bool run(int count, int grain, RangeCall call, void* context, bool stealing = true)
+			{
+				std::unique_lock<std::mutex> run_lock(run_mutex, std::try_to_lock);
+				if (!run_lock.owns_lock())
+					return false;
+
+				const int chunks = (count + grain - 1) / grain;
+				const int size = queues.size();
+				{
+					std::unique_lock<std::mutex> lock(m);
+					//	Workers still scanning the previous job's queues must leave before they are refilled.
+					done.wait(lock, [this] { return busy == 0; });
+
+					for (int q = 0; q < size; q++)
+					{
+						std::lock_guard<std::mutex> queue_lock(queues[q].m);
+						queues[q].begin = static_cast<long long>(chunks) * q / size;
+						queues[q].end = static_cast<long long>(chunks) * (q + 1) / size;
+					}
+					job = { call, context, count, grain, stealing };
+					remaining = chunks;
+					generation++;
+				}
+				wake.notify_all();
+
+				inside_run = true;
+				work(0, job);
+				inside_run = false;
+
+				std::unique_lock<std::mutex> lock(m);
+				done.wait(lock, [this] { return remaining == 0; });
+				return true;
+			}
+
+		private:
+			struct Job
+			{
+				RangeCall call;
+				void* context;
+				int count, grain;
+				bool stealing;
+			};
+
+			//	Chunks [begin, end) owned by one worker. The owner pops from the front, thieves from the back.
+			struct Queue
+			{
+				std::mutex m;
+				int begin = 0, end = 0;
+			};
+
+			std::vector<Queue> queues;
+			std::vector<std::thread> workers;
+			std::mutex run_mutex, m;
+			std::condition_variable wake, done;
+			Job job = {};
+			std::atomic<int> remaining{ 0 };
+			int busy = 0;
+			unsigned long long generation = 0;
+			bool stopping = false;
+
+			bool pop(int index, int& chunk)
+			{
+				Queue& queue = queues[index];
+				std::lock_guard<std::mutex> lock(queue.m);
+				if (queue.begin >= queue.end)
+					return false;
+				chunk = queue.begin++;
+				return true;
+			}
+
+			bool steal(int index, int& chunk)
+			{
+				const int size = queues.size();
+				for (int offset = 1; offset < size; offset++)
+				{
+					Queue& victim = queues[(index + offset) % size];
+					std::lock_guard<std::mutex> lock(victim.m);
+					if (victim.begin < victim.end)
+					{
+						chunk = --victim.end;
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void work(int index, const Job& current)
+			{
+				int chunk;
+				while (pop(index, chunk) || (current.stealing && steal(index, chunk)))
+				{
+					const int begin = chunk * current.grain;
+					current.call(current.context, begin, std::min(current.count, begin + current.grain));
+					if (remaining.fetch_sub(1) == 1)
+					{
+						std::lock_guard<std::mutex> lock(m);
+						done.notify_all();
+					}
+				}
+			}
+
+			void workerLoop(int index)
+			{
+				inside_run = true;
+				unsigned long long seen = 0;
+				while (true)
+				{
+					Job current;
+					{
+						std::unique_lock<std::mutex> lock(m);
+						wake.wait(lock, [&] { return stopping || generation != seen; });
+						if (stopping)
+							return;
+						seen = generation;
+						current = job;
+						busy++;
+					}
+
+					work(index, current);
+
+					std::lock_guard<std::mutex> lock(m);
+					busy--;
+					if (busy == 0)
+						done.notify_all();
+				}
+			}
+		};
+
+#if defined(FLUID_USE_OPENMP)
+		Backend current_backend = Backend::OPENMP;
+#else
+		Backend current_backend = Backend::THREAD_POOL;
+#endif
+		int thread_count = hardwareThreads();
+		std::unique_ptr<ThreadPool> pool;
+		std::mutex pool_mutex;
+
+		ThreadPool& getPool()
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if (!pool)
+				pool.reset(new ThreadPool(thread_count));
+			return *pool;
+		}
+
+		struct RegionJob
+		{
+			RegionCall call;
+			void* context;
+			TeamState* shared;
+		};
+
+		void runMember(void* context, int begin, int)
+		{
+			RegionJob& job = *static_cast<RegionJob*>(context);
+			Team team(*job.shared, begin);
+			job.call(job.context, team);
+		}
+
+		void runSerial(int count, int grain, RangeCall call, void* context)
+		{
+			for (int begin = 0; begin < count; begin += grain)
+				call(context, begin, std::min(count, begin + grain));
+		}
+	}
+
+	const char* backendName(Backend backend)
+	{
+		return backend == Backend::OPENMP ? "openmp" : "thread pool";
+	}
+
+	bool openmpAvailable()
+	{
+#if defined(FLUID_USE_OPENMP)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	Backend backend()
+	{
+		return current_backend;
+	}
+
+	bool setBackend(Backend backend)
+	{
+		if (backend == Backend::OPENMP && !openmpAvailable())
+			return false;
+		current_backend = backend;
+		return true;
+	}
+
+	int threadCount()
+	{
+		return thread_count;
+	}
+
+	void setThreadCount(int count)
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		thread_count = count > 0 ? count : hardwareThreads();
+		pool.reset();
+	}
+
+	void run(int count, int grain, RangeCall call, void* context)
+	{
+		grain = std::max(grain, 1);
+		if (count <= 0)
+			return;
+		if (inside_run || thread_count == 1 || count <= grain)
+		{
+			runSerial(count, grain, call, context);
+			return;
+		}
+
+#if defined(FLUID_USE_OPENMP)
+		if (current_backend == Backend::OPENMP)
+		{
+			const int chunks = (count + grain - 1) / grain;
+			#pragma omp parallel for schedule(dynamic) num_threads(thread_count)
+			for (int chunk = 0; chunk < chunks; chunk++)
+			{
+				const bool nested = inside_run;
+				inside_run = true;
+				const int begin = chunk * grain;
+				call(context, begin, std::min(count, begin + grain));
+				inside_run = nested;
+			}
+			return;
+		}
+#endif
+
+		if (!getPool().run(count, grain, call, context))
+			runSerial(count, grain, call, context);
+	}
+
+	void Team::barrier()
+	{
+		if (shared.size == 1)
+			return;
+		const unsigned int phase = shared.phase.load(std::memory_order_acquire);
+		if (shared.arrived.fetch_add(1, std::memory_order_acq_rel) == shared.size - 1)
+		{
+			shared.arrived.store(0, std::memory_order_relaxed);
+			shared.phase.store(phase + 1, std::memory_order_release);
+			return;
+		}
+		for (int spin = 0; shared.phase.load(std::memory_order_acquire) == phase; spin++)
+		{
+			if (spin > 64)
+				std::this_thread::yield();
+		}
+	}
+
+	void Team::finishLoop()
+	{
+		barrier();
+		//	Nobody touches this counter again until the next barrier, which the first member reaches after the reset.
+		if (member == 0)
+			shared.next[loops & 1].store(0, std::memory_order_relaxed);
+		loops++;
+	}
+
+	void region(RegionCall call, void* context)
+	{
+		TeamState shared;
+		if (inside_run || thread_count == 1)
+		{
+			Team team(shared, 0);
+			call(context, team);
+			return;
+		}
+
+#if defined(FLUID_USE_OPENMP)
+		if (current_backend == Backend::OPENMP)
+		{
+			#pragma omp parallel num_threads(thread_count)
+			{
+				#pragma omp single
+				shared.size = omp_get_num_threads();
+
+				inside_run = true;
+				Team team(shared, omp_get_thread_num());
+				call(context, team);
+				inside_run = false;
+			}
+			return;
+		}
+#endif
+
+		shared.size = thread_count;
+		RegionJob job = { call, context, &shared };
+		if (!getPool().run(thread_count, 1, runMember, &job, false))
+		{
+			shared.size = 1;
+			Team team(shared, 0);
+			call(context, team);
+		}
+	}
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+//	Parallel loops for the simulation phases. Runs on OpenMP when the build has it and otherwise on a
+//	persistent std::thread pool where each worker owns a share of the chunks and steals from the others
+//	once it runs out.
+namespace parallel
+{
+	enum class Backend
+	{
+		OPENMP = 0,
+		THREAD_POOL = 1
+	};
+
+	const char* backendName(Backend backend);
+	bool openmpAvailable();
+
+	Backend backend();
+	//	Returns false and keeps the current backend if OpenMP was not compiled in.
+	bool setBackend(Backend backend);
+
+	int threadCount();
+	//	0 uses every hardware thread.
+	void setThreadCount(int count);
+
+	typedef void (*RangeCall)(void* context, int begin, int end);
+
+	//	Splits [0, count) into chunks of grain indices and calls call(context, begin, end) on each.
+	//	Nested calls from inside a chunk run on the calling thread.
+	void run(int count, int grain, RangeCall call, void* context);
+
+	template <class F>
+	void forRange(int count, int grain, F&& body)
+	{
+		typedef typename std::remove_reference<F>::type Body;
+		if (count <= 0)
+			return;
+		run(count, grain, [](void* context, int begin, int end) { (*static_cast<Body*>(context))(begin, end); }, &body);
+	}
+
+	template <class F>
+	void forEach(int count, int grain, F&& body)
+	{
+		forRange(count, grain, [&body](int begin, int end) {
+			for (int i = begin; i < end; i++)
+				body(i);
+		});
+	}
+
+	//	State shared by the members of one region.
+	struct TeamState
+	{
+		int size = 1;
+		std::atomic<int> arrived{ 0 };
+		std::atomic<unsigned int> phase{ 0 };
+		//	Chunk counters for work-shared loops, alternating so one can be reset while the other is in use.
+		std::atomic<int> next[2] = {};
+	};
+
+	//	One thread's handle on a region. Every member must make the same sequence of forRange, single
+	//	and barrier calls.
+	class Team
+	{
+	public:
+		Team(TeamState& shared, int index) : shared(shared), member(index) {}
+
+		int index() const { return member; }
+		int size() const { return shared.size; }
+
+		void barrier();
+
+		//	Hands out chunks of grain indices to whichever member asks first, then waits for the whole team.
+		template <class F>
+		void forRange(int count, int grain, F&& body)
+		{
+			grain = std::max(grain, 1);
+			if (shared.size == 1)
+			{
+				for (int begin = 0; begin < count; begin += grain)
+					body(begin, std::min(count, begin + grain));
+				return;
+			}
+
+			std::atomic<int>& next = shared.next[loops & 1];
+			const int chunks = (count + grain - 1) / grain;
+			for (int chunk = next.fetch_add(1, std::memory_order_relaxed); chunk < chunks;
+				chunk = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				const int begin = chunk * grain;
+				body(begin, std::min(count, begin + grain));
+			}
+			finishLoop();
+		}
+
+		template <class F>
+		void forEach(int count, int grain, F&& body)
+		{
+			forRange(count, grain, [&body](int begin, int end) {
+				for (int i = begin; i < end; i++)
+					body(i);
+			});
+		}
+
+		//	Runs body on the first member while the others wait.
+		template <class F>
+		void single(F&& body)
+		{
+			if (member == 0)
+				body();
+			barrier();
+		}
+
+	private:
+		TeamState& shared;
+		int member;
+		unsigned int loops = 0;
+
+		void finishLoop();
+	};
+
+	typedef void (*RegionCall)(void* context, Team& team);
+
+	//	Runs call once on each of threadCount() threads, the caller included. Falls back to a team of
+	//	one when nested or when another thread is using the pool.
+	void region(RegionCall call, void* context);
+
+	template <class F>
+	void region(F&& body)
+	{
+		typedef typename std::remove_reference<F>::type Body;
+		region([](void* context, Team& team) { (*static_cast<Body*>(context))(team); }, &body);
+	}
+}
@@ -0,0 +1,600 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include "Vector2.hpp"
+#include "Particle.hpp"
+#include "ParticleStore.hpp"
+#include "Kernels.hpp"
+#include "Parallel.hpp"
+#include <iostream>
+
+//	NESTED keeps one vector per cell and moves particles between them as they cross cells. SORTED keeps
+//	every cell in one flat index array, rebuilt each step by a counting sort over all particles. HASHED
+//	sorts the same way but only over occupied cells, found through a hash table, so memory and scans
+//	scale with the fluid instead of the world and cells may lie outside [0, N) x [0, M).
+enum class GridLayout
+{
+	NESTED = 0,
+	SORTED = 1,
+	HASHED = 2
+};
+
+inline const char* gridLayoutName(GridLayout layout)
+{
+	const char* names[] = { "nested", "sorted", "hashed" };
+	return names[static_cast<int>(layout)];
+}
+
+inline bool parseGridLayout(const std::string& name, GridLayout& layout)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (name == gridLayoutName(static_cast<GridLayout>(i)))
+		{
+			layout = static_cast<GridLayout>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+class ParticleGrid
+{
+public:
+	int N, M, particleAmount = 0, maxParticleAmount = conf::START_MAX_PARTICLE_AMOUNT;
+	GridLayout layout;
+	std::vector<std::vector<std::vector<int>>> grid;
+	std::vector<Vec2i> key_to_tile;
+	Vec2f SIZE, SIZE_PER_TILE;
+
+	//	SORTED layout: cell i * M + j holds indices[cell_start[c], cell_start[c] + cell_count[c]).
+	//	HASHED layout: the same for cell c of occupied.
+	std::vector<int> cell_start, cell_count, indices;
+	//	(row, column) of every non-empty cell, in no particular order. NESTED keeps it up to date as particles
+	//	move, the other layouts refill it in rebuild(). HASHED cell c of cell_start is occupied[c].
+	std::vector<Vec2i> occupied;
+	//	SORTED and HASHED layouts: set by addParticle/deleteParticle until the next rebuild().
+	bool dirty = false;
+
+	ParticleGrid(int N, int M, Vec2f SIZE, GridLayout layout = GridLayout::NESTED) : N(N), M(M), layout(layout), SIZE(SIZE)
+	{
+		SIZE_PER_TILE = Vec2f(SIZE.x / M, SIZE.y / N);
+		if (layout == GridLayout::NESTED)
+		{
+			grid.resize(N, std::vector<std::vector<int>>(M));
+			occupied_slot.resize(N * M, -1);
+		}
+		else if (layout == GridLayout::SORTED)
+		{
+			cell_start.resize(N * M, 0);
+			cell_count.resize(N * M, 0);
+		}
+		key_to_tile.resize(maxParticleAmount, { -1, -1 });
+	}
+
+	Vec2i getTile(float x, float y) const
+	{
+		return Vec2i(std::floor(x / SIZE_PER_TILE.x), std::floor(y / SIZE_PER_TILE.y));
+	}
+
+	Vec2i getTile(const Particle& p) const
+	{
+		return getTile(p.pos.x, p.pos.y);
+	}
+
+	Vec2i getKeyTile(int key) const
+	{
+		return key_to_tile[key];
+	}
+
+	CellSpan cell(int i, int j) const
+	{
+		if (layout == GridLayout::SORTED)
+		{
+			const int c = i * M + j;
+			return { indices.data() + cell_start[c], cell_count[c] };
+		}
+		if (layout == GridLayout::HASHED)
+		{
+			const int c = findCell(i, j);
+			if (c < 0)
+				return { indices.data(), 0 };
+			return { indices.data() + cell_start[c], cell_count[c] };
+		}
+		return { grid[i][j].data(), (int)grid[i][j].size() };
+	}
+
+	//	Tile (i, j) with its in-bounds 3x3 neighbourhood, or the non-empty part of it for HASHED.
+	TileView tileView(int i, int j) const
+	{
+		TileView view;
+		view.own = cell(i, j);
+		view.neighbour_count = 0;
+		for (int di = -1; di <= 1; di++)
+		{
+			for (int dj = -1; dj <= 1; dj++)
+			{
+				const int new_i = i + di, new_j = j + dj;
+				if (layout == GridLayout::HASHED)
+				{
+					const CellSpan span = cell(new_i, new_j);
+					if (span.count != 0)
+						view.neighbours[view.neighbour_count++] = span;
+					continue;
+				}
+				if (new_i < 0 || new_i >= N || new_j < 0 || new_j >= M)
+					continue;
+				view.neighbours[view.neighbour_count++] = cell(new_i, new_j);
+			}
+		}
+		return view;
+	}
+
+	//	Tile (i, j) with the forward half of its neighbourhood, see HalfTileView.
+	HalfTileView halfTileView(int i, int j) const
+	{
+		static const int FORWARD[4][2] = { { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+		HalfTileView view;
+		view.own = cell(i, j);
+		view.forward_count = 0;
+		for (const int* offset : FORWARD)
+		{
+			const int new_i = i + offset[0], new_j = j + offset[1];
+			if (layout != GridLayout::HASHED && (new_i < 0 || new_i >= N || new_j < 0 || new_j >= M))
+				continue;
+			const CellSpan span = cell(new_i, new_j);
+			if (span.count != 0)
+				view.forward[view.forward_count++] = span;
+		}
+		return view;
+	}
+
+	//	Compact relaxation: the position value 0 of cell (i, j) stands for, and the distance between two
+	//	values, see CompactPositions.
+	Vec2f compactOrigin(int i, int j) const
+	{
+		return Vec2f((j - COMPACT_MARGIN) * SIZE_PER_TILE.x, (i - COMPACT_MARGIN) * SIZE_PER_TILE.y);
+	}
+
+	Vec2f compactStep() const
+	{
+		return SIZE_PER_TILE * ((2 * COMPACT_MARGIN + 1) / 65535.0f);
+	}
+
+	//	tileView with every cell as its slots of indices, so SORTED and HASHED layouts only.
+	CompactTileView compactTileView(int i, int j) const
+	{
+		CompactTileView view;
+		view.neighbour_count = 0;
+		for (int di = -1; di <= 1; di++)
+		{
+			for (int dj = -1; dj <= 1; dj++)
+			{
+				const int new_i = i + di, new_j = j + dj;
+				if (layout != GridLayout::HASHED && (new_i < 0 || new_i >= N || new_j < 0 || new_j >= M))
+					continue;
+				const CellSpan span = cell(new_i, new_j);
+				const Vec2f origin = compactOrigin(new_i, new_j);
+				const CompactSpan compact = { (int)(span.keys - indices.data()), span.count, origin.x, origin.y };
+				if (di == 0 && dj == 0)
+					view.own = compact;
+				if (span.count != 0)
+					view.neighbours[view.neighbour_count++] = compact;
+			}
+		}
+		return view;
+	}
+
+	//	Calls f(j) for every particle j in the half stencil of particle key: the higher keys of its own cell
+	//	and everything in its forward cells. Over all keys this meets each unordered pair once.
+	template <class F>
+	void forEachHalfNeighbour(int key, F f) const
+	{
+		const Vec2i tile = key_to_tile[key];
+		const HalfTileView view = halfTileView(tile.y, tile.x);
+		for (int n = 0; n < view.own.count; n++)
+		{
+			if (view.own.keys[n] > key)
+				f(view.own.keys[n]);
+		}
+		for (int cell = 0; cell < view.forward_count; cell++)
+		{
+			for (int n = 0; n < view.forward[cell].count; n++)
+				f(view.forward[cell].keys[n]);
+		}
+	}
+
+	void addParticle(const Particle& p, int key)
+	{
+		particleAmount++;
+		if (particleAmount > maxParticleAmount)
+		{
+			maxParticleAmount *= 2;
+			key_to_tile.resize(maxParticleAmount, { -1, -1 });
+		}
+		Vec2i tile = getTile(p);
+		key_to_tile[key] = tile;
+		if (layout != GridLayout::NESTED)
+		{
+			dirty = true;
+			return;
+		}
+		grid[tile.y][tile.x].push_back(key);
+		markOccupied(tile.y, tile.x);
+	}
+
+	void deleteParticle(int key)
+	{
+		if (layout != GridLayout::NESTED)
+		{
+			dirty = true;
+			return;
+		}
+		if (key_to_tile[key].x == -1)
+			return;
+		Vec2i tile = key_to_tile[key];
+		key_to_tile[key] = { -1, -1 };
+		grid[tile.y][tile.x].erase(std::find(grid[tile.y][tile.x].begin(), grid[tile.y][tile.x].end(), key));
+		if (grid[tile.y][tile.x].empty())
+			unmarkOccupied(tile.y, tile.x);
+	}
+
+	//	Drops the removed particles (new_index[i] < 0) and renames i to new_index[i] in the rest, for keys
+	//	[0, old_count). The kept particles must end up as [0, new_count).
+	void removeParticles(const int* new_index, int old_count, int new_count)
+	{
+		particleAmount = new_count;
+		if (layout != GridLayout::NESTED)
+		{
+			for (int key = new_count; key < old_count; key++)
+				key_to_tile[key] = { -1, -1 };
+			dirty = true;
+			return;
+		}
+
+		std::vector<std::pair<int, Vec2i>> moved;
+		for (int key = 0; key < old_count; key++)
+		{
+			if (new_index[key] == key)
+				continue;
+			const Vec2i tile = key_to_tile[key];
+			std::vector<int>& keys = grid[tile.y][tile.x];
+			keys.erase(std::find(keys.begin(), keys.end(), key));
+			if (keys.empty())
+				unmarkOccupied(tile.y, tile.x);
+			if (new_index[key] >= 0)
+				moved.push_back({ new_index[key], tile });
+		}
+		for (int key = new_count; key < old_count; key++)
+			key_to_tile[key] = { -1, -1 };
+		for (const std::pair<int, Vec2i>& move : moved)
+		{
+			key_to_tile[move.first] = move.second;
+			grid[move.second.y][move.second.x].push_back(move.first);
+			markOccupied(move.second.y, move.second.x);
+		}
+	}
+
+	//	SORTED and HASHED layouts: re-bins every particle with a stable counting sort. tiles, if given, holds
+	//	getTile() of every particle, already computed by the caller. Called by every member of team.
+	void rebuild(parallel::Team& team, const ParticleStore& particles, const Vec2i* tiles = nullptr)
+	{
+		const int count = particles.size();
+		team.single([&] {
+			particle_cell.resize(count);
+			indices.resize(count);
+		});
+
+		team.forRange(count, SORT_CHUNK_SIZE, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				const Vec2i tile = tiles != nullptr ? tiles[i] : getTile(particles.x[i], particles.y[i]);
+				key_to_tile[i] = tile;
+				particle_cell[i] = tile.y * M + tile.x;
+			}
+		});
+
+		if (layout == GridLayout::HASHED)
+			team.single([&] { hashCells(count); });
+
+		sortCells(team, count, layout == GridLayout::HASHED ? (int)occupied.size() : N * M);
+		team.single([&] {
+			if (layout == GridLayout::SORTED)
+				collectOccupied(count);
+			dirty = false;
+		});
+	}
+
+	//	Moves the particles that changed cell since the last call. NESTED layout only, the others just
+	//	rebuild(). tiles as for rebuild(). Called by every member of team.
+	void update(parallel::Team& team, const ParticleStore& particles, const Vec2i* tiles = nullptr)
+	{
+		if (layout != GridLayout::NESTED)
+		{
+			rebuild(team, particles, tiles);
+			return;
+		}
+
+		const int count = particles.size();
+		const int CHUNKS = (count + SORT_CHUNK_SIZE - 1) / SORT_CHUNK_SIZE;
+		team.single([&] {
+			if ((int)chunk_moves.size() < CHUNKS)
+				chunk_moves.resize(CHUNKS);
+		});
+
+		//	Each chunk lists its movers with the cell they left, then key_to_tile gets the new one.
+		team.forRange(count, SORT_CHUNK_SIZE, [&](int begin, int end) {
+			std::vector<std::pair<int, Vec2i>>& moves = chunk_moves[begin / SORT_CHUNK_SIZE];
+			moves.clear();
+			for (int i = begin; i < end; i++)
+			{
+				const Vec2i tile = tiles != nullptr ? tiles[i] : getTile(particles.x[i], particles.y[i]);
+				if (tile == key_to_tile[i])
+					continue;
+				moves.push_back({ i, key_to_tile[i] });
+				key_to_tile[i] = tile;
+			}
+		});
+
+		int moved = 0;
+		for (int chunk = 0; chunk < CHUNKS; chunk++)
+			moved += chunk_moves[chunk].size();
+		//	Nobody may clear chunk_moves for the next call before everyone has counted it.
+		team.barrier();
+		if (moved == 0)
+			return;
+
+		//	In a splash it is cheaper to bin every particle again than to patch the cells.
+		if (moved * REBUILD_MIGRATION_RATIO > count)
+		{
+			team.single([&] {
+				particle_cell.resize(count);
+				indices.resize(count);
+				cell_start.resize(N * M);
+				cell_count.resize(N * M);
+			});
+			team.forEach(count, SORT_CHUNK_SIZE, [&](int i) {
+				particle_cell[i] = key_to_tile[i].y * M + key_to_tile[i].x;
+			});
+			sortCells(team, count, N * M);
+			team.forEach(N, 1, [&](int i) {
+				for (int j = 0; j < M; j++)
+				{
+					const int c = i * M + j;
+					grid[i][j].assign(indices.begin() + cell_start[c], indices.begin() + cell_start[c] + cell_count[c]);
+				}
+			});
+			team.single([&] { collectOccupied(count); });
+			return;
+		}
+
+		team.single([&] {
+			row_changed.assign(N, 0);
+			for (int chunk = 0; chunk < CHUNKS; chunk++)
+			{
+				for (const std::pair<int, Vec2i>& move : chunk_moves[chunk])
+				{
+					const Vec2i tile = key_to_tile[move.first];
+					grid[tile.y][tile.x].push_back(move.first);
+					markOccupied(tile.y, tile.x);
+					row_changed[move.second.y] = 1;
+				}
+			}
+		});
+		team.forEach(N, 1, [&](int i) {
+			if (!row_changed[i])
+				return;
+			for (int j = 0; j < M; j++)
+			{
+				std::vector<int>& keys = grid[i][j];
+				keys.erase(std::remove_if(keys.begin(), keys.end(), [&](int key) {
+					return key_to_tile[key].y != i || key_to_tile[key].x != j;
+				}), keys.end());
+			}
+		});
+		team.single([&] {
+			for (int chunk = 0; chunk < CHUNKS; chunk++)
+			{
+				for (const std::pair<int, Vec2i>& move : chunk_moves[chunk])
+				{
+					if (grid[move.second.y][move.second.x].empty())
+						unmarkOccupied(move.second.y, move.second.x);
+				}
+			}
+		});
+	}
+
+	//	Follows a permutation of the particles: new index n held old particle order[n], old i is now inverse[i].
+	//	Called by every member of team with the particles already permuted.
+	void remap(parallel::Team& team, const int* order, const int* inverse, const ParticleStore& particles)
+	{
+		if (layout != GridLayout::NESTED)
+		{
+			rebuild(team, particles);
+			return;
+		}
+
+		const int count = particles.size();
+		team.single([&] { particle_cell.resize(count); });
+		team.forEach(count, SORT_CHUNK_SIZE, [&](int n) {
+			const Vec2i tile = key_to_tile[order[n]];
+			particle_cell[n] = tile.y * M + tile.x;
+		});
+		team.forEach(count, SORT_CHUNK_SIZE, [&](int n) {
+			key_to_tile[n] = Vec2i(particle_cell[n] % M, particle_cell[n] / M);
+		});
+		team.forEach(N, 1, [&](int i) {
+			for (std::vector<int>& keys : grid[i])
+			{
+				for (int& key : keys)
+					key = inverse[key];
+				std::sort(keys.begin(), keys.end());
+			}
+		});
+	}
+
+private:
+	static constexpr int SORT_CHUNK_SIZE = 4096;
+	//	update() rebuilds every cell once more than 1 / REBUILD_MIGRATION_RATIO of the particles moved.
+	static constexpr int REBUILD_MIGRATION_RATIO = 8;
+
+	std::vector<int> particle_cell, chunk_offsets;
+	std::vector<std::vector<std::pair<int, Vec2i>>> chunk_moves;
+	std::vector<char> row_changed;
+	//	NESTED layout: position of cell i * M + j in occupied, -1 while it is empty.
+	std::vector<int> occupied_slot;
+
+	void markOccupied(int i, int j)
+	{
+		int& slot = occupied_slot[i * M + j];
+		if (slot >= 0)
+			return;
+		slot = occupied.size();
+		occupied.push_back(Vec2i(i, j));
+	}
+
+	void unmarkOccupied(int i, int j)
+	{
+		int& slot = occupied_slot[i * M + j];
+		if (slot < 0)
+			return;
+		const Vec2i last = occupied.back();
+		occupied[slot] = last;
+		occupied_slot[last.x * M + last.y] = slot;
+		occupied.pop_back();
+		slot = -1;
+	}
+
+	//	Refills occupied from the cells of the last sortCells(), without visiting the empty ones.
+	void collectOccupied(int count)
+	{
+		if (layout == GridLayout::NESTED)
+		{
+			for (const Vec2i& tile : occupied)
+				occupied_slot[tile.x * M + tile.y] = -1;
+		}
+		occupied.clear();
+		for (int k = 0; k < count; k++)
+		{
+			const int c = particle_cell[indices[k]];
+			if (k > 0 && c == particle_cell[indices[k - 1]])
+				continue;
+			if (layout == GridLayout::NESTED)
+				occupied_slot[c] = occupied.size();
+			occupied.push_back(Vec2i(c / M, c % M));
+		}
+	}
+
+	//	Stable counting sort of particles [0, count) by particle_cell into indices, cell_start and cell_count,
+	//	which must hold CELLS entries. Called by every member of team.
+	void sortCells(parallel::Team& team, int count, int CELLS)
+	{
+		const int CHUNKS = (count + SORT_CHUNK_SIZE - 1) / SORT_CHUNK_SIZE;
+		team.single([&] { chunk_offsets.assign((size_t)CHUNKS * CELLS, 0); });
+
+		//	Histogram of each chunk of particles.
+		team.forRange(count, SORT_CHUNK_SIZE, [&](int begin, int end) {
+			int* histogram = chunk_offsets.data() + (size_t)(begin / SORT_CHUNK_SIZE) * CELLS;
+			for (int i = begin; i < end; i++)
+				histogram[particle_cell[i]]++;
+		});
+
+		team.forEach(CELLS, SORT_CHUNK_SIZE, [&](int c) {
+			int total = 0;
+			for (int chunk = 0; chunk < CHUNKS; chunk++)
+				total += chunk_offsets[(size_t)chunk * CELLS + c];
+			cell_count[c] = total;
+		});
+
+		team.single([&] {
+			int start = 0;
+			for (int c = 0; c < CELLS; c++)
+			{
+				cell_start[c] = start;
+				start += cell_count[c];
+			}
+		});
+
+		//	Turns the histograms into each chunk's first slot in every cell.
+		team.forEach(CELLS, SORT_CHUNK_SIZE, [&](int c) {
+			int offset = cell_start[c];
+			for (int chunk = 0; chunk < CHUNKS; chunk++)
+			{
+				int& slot = chunk_offsets[(size_t)chunk * CELLS + c];
+				const int chunk_count = slot;
+				slot = offset;
+				offset += chunk_count;
+			}
+		});
+
+		team.forRange(count, SORT_CHUNK_SIZE, [&](int begin, int end) {
+			int* offsets = chunk_offsets.data() + (size_t)(begin / SORT_CHUNK_SIZE) * CELLS;
+			for (int i = begin; i < end; i++)
+				indices[offsets[particle_cell[i]]++] = i;
+		});
+	}
+	//	HASHED layout: open addressing table from packed (row, column) to an index into occupied, -1 if free.
+	std::vector<uint64_t> slot_keys;
+	std::vector<int> slot_cells;
+	int slot_bits = 0;
+
+	static uint64_t packCell(int i, int j)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) | static_cast<uint32_t>(j);
+	}
+
+	int slotOf(uint64_t key) const
+	{
+		return static_cast<int>((key * 0x9E3779B97F4A7C15ull) >> (64 - slot_bits));
+	}
+
+	int findCell(int i, int j) const
+	{
+		if (slot_bits == 0)
+			return -1;
+		const uint64_t key = packCell(i, j);
+		const int mask = (1 << slot_bits) - 1;
+		for (int slot = slotOf(key); slot_cells[slot] >= 0; slot = (slot + 1) & mask)
+		{
+			if (slot_keys[slot] == key)
+				return slot_cells[slot];
+		}
+		return -1;
+	}
+
+	//	Replaces the row-major cell ids in particle_cell with indices into occupied, which it refills.
+	void hashCells(int count)
+	{
+		slot_bits = 4;
+		while ((1 << slot_bits) < 2 * count)
+			slot_bits++;
+		const int mask = (1 << slot_bits) - 1;
+		slot_keys.assign(1 << slot_bits, 0);
+		slot_cells.assign(1 << slot_bits, -1);
+		occupied.clear();
+
+		for (int p = 0; p < count; p++)
+		{
+			const Vec2i tile = key_to_tile[p];
+			const uint64_t key = packCell(tile.y, tile.x);
+			int slot = slotOf(key);
+			while (slot_cells[slot] >= 0 && slot_keys[slot] != key)
+				slot = (slot + 1) & mask;
+			if (slot_cells[slot] < 0)
+			{
+				slot_keys[slot] = key;
+				slot_cells[slot] = occupied.size();
+				occupied.push_back(Vec2i(tile.y, tile.x));
+			}
+			particle_cell[p] = slot_cells[slot];
+		}
+		cell_start.resize(occupied.size());
+		cell_count.resize(occupied.size());
+	}
+};
\ No newline at end of file
@@ -0,0 +1,193 @@
+#pragma once
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <new>
+#include "Conf.hpp"
+
+class ParticleSprings
+{
+public:
+	std::vector<int> keys;
+	std::vector<float> arr;
+	int particleAmount = 0, maxParticleAmount = conf::START_MAX_PARTICLE_AMOUNT;
+
+	//	Largest arr springs may use, 2 GB. It also keeps every spring id below 2^31, so ids stay ints.
+	static constexpr size_t MAX_TABLE_BYTES = size_t(1) << 31;
+
+	static size_t tableBytes(size_t capacity)
+	{
+		return capacity * capacity * sizeof(float);
+	}
+
+	static bool fits(size_t capacity)
+	{
+		return tableBytes(capacity) <= MAX_TABLE_BYTES;
+	}
+
+	//	arr is maxParticleAmount^2 floats, so it is only allocated once springs are used.
+	bool allocated() const
+	{
+		return !arr.empty();
+	}
+
+	//	Returns false and leaves arr empty if the table is larger than MAX_TABLE_BYTES or cannot be allocated.
+	bool allocate()
+	{
+		if (!arr.empty())
+			return true;
+		if (!fits(maxParticleAmount))
+			return false;
+		try
+		{
+			arr.resize((size_t)maxParticleAmount * maxParticleAmount, 0.0f);
+		}
+		catch (const std::bad_alloc&)
+		{
+			std::vector<float>().swap(arr);
+			return false;
+		}
+		return true;
+	}
+
+	bool addParticle()
+	{
+		return addParticles(1);
+	}
+
+	//	Grows arr at most once for the whole batch. Returns false if arr is allocated and the grown table does
+	//	not fit, see allocate(): every spring is dropped then and arr released.
+	bool addParticles(int count)
+	{
+		particleAmount += count;
+		size_t capacity = maxParticleAmount;
+		while ((size_t)particleAmount > capacity)
+			capacity *= 2;
+		if (capacity == (size_t)maxParticleAmount)
+			return true;
+
+		const int old_capacity = maxParticleAmount;
+		maxParticleAmount = (int)std::min<size_t>(capacity, INT_MAX);
+		if (arr.empty())
+			return true;
+
+		std::vector<float> new_arr;
+		if (fits(capacity))
+		{
+			try
+			{
+				new_arr.resize(capacity * capacity, 0.0f);
+			}
+			catch (const std::bad_alloc&)
+			{
+			}
+		}
+		if (new_arr.empty())
+		{
+			keys.clear();
+			std::vector<float>().swap(arr);
+			return false;
+		}
+
+		std::vector<int> new_keys;
+		new_keys.reserve(keys.size());
+
+		for (int p : keys)
+		{
+			std::pair<int, int> id = std::make_pair(p / old_capacity, p % old_capacity);
+			int new_id = getSpringId(id.first, id.second);
+			new_keys.push_back(new_id);
+			new_arr[new_id] = arr[p];
+		}
+
+		keys.swap(new_keys);
+		arr.swap(new_arr);
+		return true;
+	}
+
+	//	Drops the springs of removed particles (new_index[i] < 0) and renames i to new_index[i] in the rest.
+	void removeParticles(const int* new_index, int new_count)
+	{
+		particleAmount = new_count;
+		if (arr.empty())
+			return;
+
+		std::vector<std::pair<int, float>> kept;
+		kept.reserve(keys.size());
+		for (int key : keys)
+		{
+			const std::pair<int, int> id = reverseId(key);
+			const float length = arr[key];
+			arr[key] = 0.0f;
+			if (new_index[id.first] >= 0 && new_index[id.second] >= 0)
+				kept.push_back({ getSpringId(new_index[id.first], new_index[id.second]), length });
+		}
+		keys.clear();
+		for (const std::pair<int, float>& spring : kept)
+		{
+			keys.push_back(spring.first);
+			arr[spring.first] = spring.second;
+		}
+	}
+
+	//	Renames particle i to inverse[i] in every spring.
+	void remap(const int* inverse)
+	{
+		if (arr.empty())
+			return;
+
+		const int KEYS_SIZE = (int)keys.size();
+		std::vector<float> lengths(KEYS_SIZE);
+		for (int k = 0; k < KEYS_SIZE; k++)
+		{
+			lengths[k] = arr[keys[k]];
+			arr[keys[k]] = 0.0f;
+		}
+		for (int k = 0; k < KEYS_SIZE; k++)
+		{
+			const std::pair<int, int> id = reverseId(keys[k]);
+			keys[k] = getSpringId(inverse[id.first], inverse[id.second]);
+			arr[keys[k]] = lengths[k];
+		}
+	}
+
+	//	Below 2^31 while arr is allocated, see MAX_TABLE_BYTES.
+	int getSpringId(int i, int j) const
+	{
+		std::pair<int, int> p = std::minmax(i, j);
+		return (int)((size_t)p.first * maxParticleAmount + p.second);
+	}
+
+	std::pair<int, int> reverseId(int id) const
+	{
+		return std::make_pair(id / maxParticleAmount, id % maxParticleAmount);
+	}
+
+	float springLen(int i, int j)
+	{
+		return arr[(size_t)i * maxParticleAmount + j];
+	}
+
+	bool springExists(int i, int j) const
+	{
+		return arr[(size_t)i * maxParticleAmount + j] != 0.0f;
+	}
+
+	void addSpring(int i, int j, float L)
+	{
+		keys.push_back(getSpringId(i, j));
+		arr[(size_t)i * maxParticleAmount + j] = L;
+	}
+
+	void setSpring(int i, int j, float L)
+	{
+		arr[(size_t)i * maxParticleAmount + j] = L;
+	}
+
+	void deleteSpring(int i, int j)
+	{
+		arr[(size_t)i * maxParticleAmount + j] = 0.0f;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Kernels.hpp"
+#include "Parallel.hpp"
+#include "Particle.hpp"
+
+//	Optional per-particle value, such as dye concentration, temperature, material id or age.
+struct ParticleChannel
+{
+	std::string name;
+	float initial;
+	std::vector<float> values;
+};
+
+//	The simulation's particles with one array per component, so a phase only pulls the components it uses
+//	through cache. Particle remains the type for spawning and for reading one particle at a time.
+class ParticleStore
+{
+public:
+	std::vector<float> x, y, px, py, vx, vy;
+	//	Allocated only when a scene asks for them. They follow the particles through additions, reorders
+	//	and removals, but the step kernels never see them.
+	std::vector<ParticleChannel> channels;
+
+	size_t size() const
+	{
+		return x.size();
+	}
+
+	bool empty() const
+	{
+		return x.empty();
+	}
+
+	void clear()
+	{
+		for (std::vector<float>* component : components())
+			component->clear();
+	}
+
+	//	New particles start with every channel at its initial value.
+	void push_back(const Particle& p)
+	{
+		x.push_back(p.pos.x);
+		y.push_back(p.pos.y);
+		px.push_back(p.prev_pos.x);
+		py.push_back(p.prev_pos.y);
+		vx.push_back(p.v.x);
+		vy.push_back(p.v.y);
+		for (ParticleChannel& channel : channels)
+			channel.values.push_back(channel.initial);
+	}
+
+	//	Index of the channel called name, which is created with every particle at initial if it is new.
+	int addChannel(const std::string& name, float initial = 0.0f)
+	{
+		const int existing = findChannel(name);
+		if (existing >= 0)
+			return existing;
+		channels.push_back({ name, initial, std::vector<float>(size(), initial) });
+		return channels.size() - 1;
+	}
+
+	//	-1 if there is no channel called name.
+	int findChannel(const std::string& name) const
+	{
+		const int CHANNELS_SIZE = (int)channels.size();
+		for (int c = 0; c < CHANNELS_SIZE; c++)
+		{
+			if (channels[c].name == name)
+				return c;
+		}
+		return -1;
+	}
+
+	std::vector<float>& channel(int index)
+	{
+		return channels[index].values;
+	}
+
+	const std::vector<float>& channel(int index) const
+	{
+		return channels[index].values;
+	}
+
+	//	A copy of particle i.
+	Particle operator[](int i) const
+	{
+		Particle p(pos(i));
+		p.prev_pos = Vec2f(px[i], py[i]);
+		p.v = velocity(i);
+		return p;
+	}
+
+	void set(int i, const Particle& p)
+	{
+		x[i] = p.pos.x;
+		y[i] = p.pos.y;
+		px[i] = p.prev_pos.x;
+		py[i] = p.prev_pos.y;
+		vx[i] = p.v.x;
+		vy[i] = p.v.y;
+	}
+
+	Vec2f pos(int i) const
+	{
+		return Vec2f(x[i], y[i]);
+	}
+
+	Vec2f velocity(int i) const
+	{
+		return Vec2f(vx[i], vy[i]);
+	}
+
+	ParticleView view()
+	{
+		return { x.data(), y.data(), px.data(), py.data(), vx.data(), vy.data() };
+	}
+
+	//	Removes the particles at indices, which must be sorted and unique, by moving the last remaining
+	//	particle into each freed slot. new_index[i] becomes the slot of old particle i, or -1 if it was removed.
+	void swapRemove(const std::vector<int>& indices, std::vector<int>& new_index)
+	{
+		int N = size();
+		new_index.resize(N);
+		//	holder[slot] is the old index of the particle in slot.
+		std::vector<int> holder(N);
+		for (int i = 0; i < N; i++)
+			new_index[i] = holder[i] = i;
+		const std::vector<std::vector<float>*> all = components();
+		for (int r = indices.size() - 1; r >= 0; r--)
+		{
+			const int i = indices[r], last = N - 1;
+			new_index[holder[i]] = -1;
+			if (i != last)
+			{
+				for (std::vector<float>* component : all)
+					(*component)[i] = (*component)[last];
+				holder[i] = holder[last];
+				new_index[holder[i]] = i;
+			}
+			for (std::vector<float>* component : all)
+				component->pop_back();
+			N--;
+		}
+	}
+
+	//	Moves particle order[n] to n for every n, one component at a time through scratch. Called by every
+	//	member of team.
+	void permute(parallel::Team& team, const int* order, std::vector<float>& scratch)
+	{
+		const int N = size();
+		const std::vector<std::vector<float>*> all = components();
+		for (std::vector<float>* component : all)
+		{
+			team.single([&] { scratch.resize(N); });
+			team.forEach(N, PERMUTE_CHUNK_SIZE, [&](int n) {
+				scratch[n] = (*component)[order[n]];
+			});
+			team.single([&] { component->swap(scratch); });
+		}
+	}
+
+private:
+	static constexpr int PERMUTE_CHUNK_SIZE = 4096;
+
+	//	Every per-particle array, channels included.
+	std::vector<std::vector<float>*> components()
+	{
+		std::vector<std::vector<float>*> all = { &x, &y, &px, &py, &vx, &vy };
+		for (ParticleChannel& channel : channels)
+			all.push_back(&channel.values);
+		return all;
+	}
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "Simulation.hpp"
+#include <string>
+#include <vector>
+
+//	Predefined starting states shared by the app and the headless runner.
+namespace scenes
+{
+	inline void spawnBlock(Simulation& sim, Vec2f start, int rows, int columns)
+	{
+		const float space_between = 2.0f * sim.config.particle_radius;
+
+		std::vector<Particle> block;
+		block.reserve(rows * columns);
+		for (int i = 0; i < rows; i++) {
+			for (int j = 0; j < columns; j++) {
+				block.push_back(Particle(Vec2f(start.x + j * space_between, start.y - i * space_between)));
+			}
+		}
+		sim.addParticles(block);
+	}
+
+	//	The 40x40 block the app starts with.
+	inline void block(Simulation& sim)
+	{
+		const SimulationConfig& c = sim.config;
+		spawnBlock(sim, Vec2f(c.X * 0.4, c.Y * 0.8), 40, 40);
+	}
+
+	//	A tall column of water against the left wall.
+	inline void dam(Simulation& sim)
+	{
+		const SimulationConfig& c = sim.config;
+		spawnBlock(sim, Vec2f(c.particle_radius, c.Y * 0.95), 90, 70);
+	}
+
+	//	A wide settled pool with a circular obstacle above it.
+	inline void pool(Simulation& sim)
+	{
+		const SimulationConfig& c = sim.config;
+		spawnBlock(sim, Vec2f(c.particle_radius, c.Y * 0.35), 35, 180);
+		sim.objects.push_back(new CircleObject(Vec2f(c.X * 0.5, c.Y * 0.7), c.Y * 0.1));
+	}
+
+	//	50k particles in a world three times as wide, for measuring scaling. Resizes the world.
+	inline void large(Simulation& sim)
+	{
+		sim.config.X *= 3;
+		sim.config.Y *= 3;
+		sim.createGrid();
+		const SimulationConfig& c = sim.config;
+		spawnBlock(sim, Vec2f(c.X * 0.3, c.Y * 0.95), 250, 200);
+	}
+
+	//	A dam break at the left end of a channel twenty times as wide as the window, so most of the grid
+	//	stays empty. Resizes the world.
+	inline void channel(Simulation& sim)
+	{
+		sim.config.X *= 20;
+		sim.createGrid();
+		const SimulationConfig& c = sim.config;
+		spawnBlock(sim, Vec2f(c.particle_radius, c.Y * 0.95), 90, 70);
+	}
+
+	//	Two columns of water collapsing into each other, the right one carrying dye in a "dye" channel.
+	inline void mixing(Simulation& sim)
+	{
+		const SimulationConfig& c = sim.config;
+		const int dye = sim.particles.addChannel("dye");
+		spawnBlock(sim, Vec2f(c.particle_radius, c.Y * 0.95), 90, 45);
+		const int first = (int)sim.particles.size();
+		spawnBlock(sim, Vec2f(c.X - 90 * c.particle_radius, c.Y * 0.95), 90, 45);
+		const int last = (int)sim.particles.size();
+		for (int i = first; i < last; i++)
+			sim.particles.channel(dye)[i] = 1.0f;
+	}
+
+	struct Scene
+	{
+		const char* name;
+		void (*load)(Simulation& sim);
+	};
+
+	inline const std::vector<Scene>& all()
+	{
+		static const std::vector<Scene> list = { { "block", block }, { "dam", dam }, { "pool", pool }, { "large", large }, { "channel", channel }, { "mixing", mixing } };
+		return list;
+	}
+
+	inline bool load(Simulation& sim, const std::string& name)
+	{
+		for (const Scene& scene : all())
+		{
+			if (name == scene.name)
+			{
+				scene.load(sim);
+				return true;
+			}
+		}
+		return false;
+	}
+}
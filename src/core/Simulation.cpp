@@ -0,0 +1,709 @@
+#include "Simulation.hpp"
+#include "CpuDispatch.hpp"
+#include "Parallel.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <utility>
+#include <mutex>
+
+Simulation::Simulation(const SimulationConfig& config) : config(config)
+{
+	createGrid();
+}
+
+void Simulation::deleteWater()
+{
+	particles.clear();
+	createGrid();
+	springs = ParticleSprings();
+}
+
+void Simulation::createGrid()
+{
+	const float cell = config.h * tuning.cell_scale;
+	int GRID_SIZE_X = ceil(config.X / cell), GRID_SIZE_Y = ceil(config.Y / cell);
+	//	Without walls particles can leave [0, X) x [0, Y), which only the hashed grid can hold.
+	if (!config.bounded)
+		tuning.grid_layout = GridLayout::HASHED;
+	grid = ParticleGrid(GRID_SIZE_Y, GRID_SIZE_X, Vec2f(config.X + 0.0001, config.Y + 0.0001), tuning.grid_layout);
+	neighbours.invalidate();
+
+	for (int i = 0; i < particles.size(); i++)
+	{
+		grid.addParticle(particles[i], i);
+	}
+}
+
+bool Simulation::addParticle(Particle p)
+{
+	if (config.bounded && (p.pos.x < 0 || p.pos.y < 0 || p.pos.x >= config.X || p.pos.y >= config.Y))
+		return true;
+	particles.push_back(p);
+	grid.addParticle(p, particles.size() - 1);
+	neighbours.invalidate();
+	return springs.addParticle();
+}
+
+bool Simulation::addParticles(const std::vector<Particle>& batch)
+{
+	const int first = particles.size();
+	for (const Particle& p : batch)
+	{
+		if (config.bounded && (p.pos.x < 0 || p.pos.y < 0 || p.pos.x >= config.X || p.pos.y >= config.Y))
+			continue;
+		particles.push_back(p);
+		grid.addParticle(p, particles.size() - 1);
+	}
+	neighbours.invalidate();
+	return springs.addParticles(particles.size() - first);
+}
+
+void Simulation::removeParticles(std::vector<int> indices)
+{
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	const int old_count = particles.size();
+	indices.erase(std::lower_bound(indices.begin(), indices.end(), old_count), indices.end());
+	indices.erase(indices.begin(), std::lower_bound(indices.begin(), indices.end(), 0));
+	if (indices.empty())
+		return;
+
+	std::vector<int> new_index;
+	particles.swapRemove(indices, new_index);
+	grid.removeParticles(new_index.data(), old_count, particles.size());
+	springs.removeParticles(new_index.data(), particles.size());
+	neighbours.invalidate();
+}
+
+void Simulation::setTuning(const StepTuning& new_tuning)
+{
+	const float old_scale = tuning.cell_scale;
+	tuning = new_tuning;
+	tuning.spring_chunk = std::max(tuning.spring_chunk, 1);
+	tuning.spring_batch = std::clamp(tuning.spring_batch, 1, StepTuning::MAX_SPRING_BATCH);
+	tuning.colour_stride = std::max(tuning.colour_stride, 3);
+	tuning.verlet_skin = std::max(tuning.verlet_skin, 0.0f);
+	tuning.jacobi_weight = std::clamp(tuning.jacobi_weight, 0.01f, 1.0f);
+	tuning.cell_scale = std::max(tuning.cell_scale, tuning.pair_list ? 1.0f + tuning.verlet_skin : 1.0f);
+	if (tuning.compact && tuning.grid_layout == GridLayout::NESTED)
+		tuning.grid_layout = GridLayout::SORTED;
+	if (tuning.cell_scale != old_scale || tuning.grid_layout != grid.layout)
+		createGrid();
+}
+
+namespace
+{
+	typedef void (Simulation::*StepFunction)(parallel::Team& team, const StepConstants& c);
+
+	template <unsigned... Features>
+	std::array<StepFunction, sizeof...(Features)> makeStepTable(std::integer_sequence<unsigned, Features...>)
+	{
+		return { &Simulation::step<Features>... };
+	}
+
+	//	One step<> instantiation per combination of optional phases, indexed by the feature mask.
+	const std::array<StepFunction, features::COMBINATIONS> STEP_TABLE =
+		makeStepTable(std::make_integer_sequence<unsigned, features::COMBINATIONS>());
+
+	//	Bytes behind StepTimings::relaxation_bytes. A float visit reads the neighbour's index and position in
+	//	both passes and writes the position in the second, a pair visit reads the 16-byte pair instead of
+	//	the index, and a compact visit moves 2-byte values from consecutive slots. Per particle there is
+	//	the own read and write, plus encoding and decoding for compact. Jacobi reads the neighbour's index and
+	//	position in both passes and its pressures in the second, and writes to separate arrays.
+	const float RELAX_FLOAT_VISIT = 32, RELAX_PAIR_VISIT = 56, RELAX_COMPACT_VISIT = 12, RELAX_JACOBI_VISIT = 32;
+	const float RELAX_FLOAT_PARTICLE = 20, RELAX_COMPACT_PARTICLE = 56, RELAX_JACOBI_PARTICLE = 36;
+}
+
+unsigned Simulation::featureMask() const
+{
+	unsigned mask = 0;
+	if (config.k_spring != 0.0f)
+		mask |= features::SPRINGS;
+	if (config.alpha_viscosity != 0.0f || config.beta_viscosity != 0.0f)
+		mask |= features::VISCOSITY;
+	if (!objects.empty())
+	{
+		mask |= features::OBJECTS;
+		if (config.k_stick != 0.0f)
+			mask |= features::STICKINESS;
+	}
+	return mask;
+}
+
+bool Simulation::reserveSprings()
+{
+	return (featureMask() & features::SPRINGS) == 0 || springs.allocate();
+}
+
+void Simulation::update()
+{
+	const StepConstants c(config);
+	active_features = featureMask();
+	if (!reserveSprings())
+		active_features &= ~features::SPRINGS;
+	reorder_due = tuning.reorder_interval > 0 && ++steps_since_reorder >= tuning.reorder_interval;
+	if (reorder_due)
+		steps_since_reorder = 0;
+	const StepFunction step = STEP_TABLE[active_features];
+	member_idle.assign(std::max(parallel::threadCount(), 1), 0.0f);
+	member_visits.assign(member_idle.size(), 0.0);
+	parallel::region([&](parallel::Team& team) {
+		(this->*step)(team, c);
+	});
+}
+
+template <unsigned Features>
+void Simulation::step(parallel::Team& team, const StepConstants& c)
+{
+	constexpr bool SPRINGS = (Features & features::SPRINGS) != 0;
+	constexpr bool VISCOSITY = (Features & features::VISCOSITY) != 0;
+	constexpr bool STICKINESS = (Features & features::STICKINESS) != 0;
+	constexpr bool OBJECTS = (Features & features::OBJECTS) != 0;
+
+	//	Every phase ends with a barrier, so the first member's clock covers the whole team.
+	const bool timer = team.index() == 0;
+	Clock clock;
+
+	//	Particles added or removed since the last step.
+	if (grid.layout != GridLayout::NESTED && grid.dirty)
+		grid.rebuild(team, particles);
+
+	if (tuning.pair_list)
+	{
+		integrateBegin(team, c);
+		if (timer)
+			timings.velocity = clock.restart();
+
+		const bool rebuilt = buildNeighbours(team, c);
+		if (timer)
+		{
+			timings.neighbours = clock.restart();
+			timings.neighbour_rebuilds = rebuilt;
+		}
+
+		if constexpr (VISCOSITY)
+			applyViscosity(team, c);
+		if (timer)
+			timings.viscosity = clock.restart();
+	}
+	else
+	{
+		if constexpr (VISCOSITY)
+			applyViscosity(team, c);
+		if (timer)
+			timings.viscosity = clock.restart();
+
+		//	Gravity changes every velocity alike, so viscosity, which sees only differences, may run before it.
+		integrateBegin(team, c);
+		if (timer)
+		{
+			timings.velocity = clock.restart();
+			timings.neighbours = timings.neighbour_rebuilds = 0;
+		}
+	}
+
+	if constexpr (SPRINGS)
+	{
+		adjustStrings(team, c);
+		if (timer)
+			timings.adjust_springs = clock.restart();
+		applyStrings(team, c);
+		if (timer)
+			timings.apply_springs = clock.restart();
+	}
+	else if (timer)
+	{
+		timings.adjust_springs = timings.apply_springs = 0;
+	}
+
+	doubleDensityRelaxation(team, c);
+	if (timer)
+		timings.relaxation = clock.restart();
+
+	if constexpr (STICKINESS)
+		handleStickiness(team, c);
+	if (timer)
+		timings.stickiness = clock.restart();
+
+	if constexpr (OBJECTS)
+		applyCollisions(team);
+	if (timer)
+		timings.collisions = clock.restart();
+
+	integrateEnd(team, c);
+	if (timer)
+		timings.bounds_update = clock.restart();
+
+	if (reorder_due)
+		reorderParticles(team);
+	if (timer)
+	{
+		timings.reorder = clock.restart();
+		//	The sweeps are behind several barriers by now.
+		float idle = 0.0f;
+		for (int member = 0; member < team.size(); member++)
+			idle += member_idle[member];
+		timings.tile_idle = idle / team.size();
+		double visits = 0.0;
+		for (int member = 0; member < team.size(); member++)
+			visits += member_visits[member];
+		float per_visit = RELAX_FLOAT_VISIT, per_particle = RELAX_FLOAT_PARTICLE;
+		if (tuning.pair_list)
+			per_visit = RELAX_PAIR_VISIT;
+		else if (tuning.jacobi)
+			per_visit = RELAX_JACOBI_VISIT, per_particle = RELAX_JACOBI_PARTICLE;
+		else if (tuning.compact && !compact_overflow)
+			per_visit = RELAX_COMPACT_VISIT, per_particle = RELAX_COMPACT_PARTICLE;
+		timings.compact_fallbacks = tuning.compact && !tuning.pair_list && compact_overflow;
+		timings.relaxation_bytes = visits * per_visit + particles.size() * per_particle;
+	}
+}
+
+void Simulation::handleStickiness(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	team.single([&] { object_views = objectViews(); });
+	const int OBJECTS_SIZE = object_views.size();
+
+	team.forRange(particles.size(), OBJECT_CHUNK_SIZE, [&](int begin, int end) {
+		kernels.stick(particles.view(), begin, end, object_views.data(), OBJECTS_SIZE, c);
+	});
+}
+
+void Simulation::applyCollisions(parallel::Team& team)
+{
+	const KernelTable& kernels = cpu::kernels();
+	team.single([&] { object_views = objectViews(); });
+	const int OBJECTS_SIZE = object_views.size();
+
+	team.forRange(particles.size(), OBJECT_CHUNK_SIZE, [&](int begin, int end) {
+		kernels.collide(particles.view(), begin, end, object_views.data(), OBJECTS_SIZE);
+	});
+}
+
+std::vector<ObjectView> Simulation::objectViews() const
+{
+	std::vector<ObjectView> views;
+	views.reserve(objects.size());
+	for (const CollisionObject* object : objects)
+		views.push_back(object->view());
+	return views;
+}
+
+void Simulation::colourTiles()
+{
+	const int stride = tuning.colour_stride;
+	std::vector<std::pair<int, int>> ijs;
+	for (int i = 0; i < stride; i++)
+	{
+		for (int j = 0; j < stride; j++)
+			ijs.push_back({ i, j });
+	}
+	std::random_device rd;
+	std::mt19937 g(rd());
+
+	std::shuffle(ijs.begin(), ijs.end(), g);
+
+	//	Shuffles or, with cost_order, sorts one colour's tiles.
+	std::vector<std::pair<int, Vec2i>> costs;
+	auto order = [&](std::vector<Vec2i>& tiles) {
+		if (!tuning.cost_order)
+		{
+			std::shuffle(tiles.begin(), tiles.end(), g);
+			return;
+		}
+		costs.clear();
+		for (const Vec2i& tile : tiles)
+		{
+			const TileView view = grid.tileView(tile.x, tile.y);
+			int around = 0;
+			for (int cell = 0; cell < view.neighbour_count; cell++)
+				around += view.neighbours[cell].count;
+			costs.push_back({ view.own.count * around, tile });
+		}
+		std::sort(costs.begin(), costs.end(), [](const std::pair<int, Vec2i>& a, const std::pair<int, Vec2i>& b) {
+			return a.first > b.first;
+		});
+		const int TILES_SIZE = (int)tiles.size();
+		for (int t = 0; t < TILES_SIZE; t++)
+			tiles[t] = costs[t].second;
+	};
+
+	//	Only the occupied cells are visited, and hashed cells can have negative coordinates.
+	const int COLOURS_SIZE = (int)ijs.size();
+	colour_tiles.resize(COLOURS_SIZE);
+	std::vector<int> colour_of(stride * stride);
+	for (int ij = 0; ij < COLOURS_SIZE; ij++)
+	{
+		colour_of[ijs[ij].first * stride + ijs[ij].second] = ij;
+		colour_tiles[ij].clear();
+	}
+	for (const Vec2i& tile : grid.occupied)
+	{
+		const int i = (tile.x % stride + stride) % stride, j = (tile.y % stride + stride) % stride;
+		colour_tiles[colour_of[i * stride + j]].push_back(tile);
+	}
+	for (std::vector<Vec2i>& tiles_to_check : colour_tiles)
+		order(tiles_to_check);
+}
+
+template <class F>
+void Simulation::sweepTiles(parallel::Team& team, F&& body)
+{
+	typedef std::chrono::steady_clock SteadyClock;
+	team.single([&] { colourTiles(); });
+
+	float& idle = member_idle[team.index()];
+	const int COLOURS_SIZE = (int)colour_tiles.size();
+	for (int ij = 0; ij < COLOURS_SIZE; ij++)
+	{
+		const std::vector<Vec2i>& tiles_to_check = colour_tiles[ij];
+		SteadyClock::time_point finished = SteadyClock::now();
+		team.forEach(tiles_to_check.size(), 1, [&](int t) {
+			body(tiles_to_check[t]);
+			finished = SteadyClock::now();
+		});
+		idle += std::chrono::duration<float, std::micro>(SteadyClock::now() - finished).count();
+	}
+}
+
+void Simulation::doubleDensityRelaxation(parallel::Team& team, const StepConstants& c)
+{
+	if (tuning.jacobi && !tuning.pair_list)
+	{
+		jacobiRelaxation(team, c);
+		return;
+	}
+	if (tuning.compact && !tuning.pair_list && compactRelaxation(team, c))
+		return;
+
+	const KernelTable& kernels = cpu::kernels();
+	const PairView pairs = neighbours.view();
+	const ParticleView view = particles.view();
+	double& visits = member_visits[team.index()];
+
+	sweepTiles(team, [&](const Vec2i& tile) {
+		if (tuning.pair_list)
+		{
+			const CellSpan own = grid.cell(tile.x, tile.y);
+			for (int n = 0; n < own.count; n++)
+				visits += pairs.start[own.keys[n] + 1] - pairs.start[own.keys[n]];
+			kernels.densityPairs(view, own, pairs, c);
+		}
+		else
+		{
+			const TileView neighbourhood = grid.tileView(tile.x, tile.y);
+			int around = 0;
+			for (int cell = 0; cell < neighbourhood.neighbour_count; cell++)
+				around += neighbourhood.neighbours[cell].count;
+			visits += (double)neighbourhood.own.count * around;
+			kernels.densityTile(view, neighbourhood, c);
+		}
+	});
+}
+
+bool Simulation::compactRelaxation(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const int count = particles.size();
+	const Vec2f step = grid.compactStep();
+	const Vec2f inv_step(1.0f / step.x, 1.0f / step.y);
+	const int* indices = grid.indices.data();
+	double& visits = member_visits[team.index()];
+
+	team.single([&] {
+		compact_x.resize(count);
+		compact_y.resize(count);
+		compact_overflow = false;
+	});
+	const CompactPositions positions = { compact_x.data(), compact_y.data(), step.x, step.y, inv_step.x, inv_step.y };
+
+	//	Each particle is encoded relative to its cell at the last grid update, like the kernels see it.
+	team.forRange(count, PARTICLE_CHUNK_SIZE, [&](int begin, int end) {
+		bool fits = true;
+		for (int s = begin; s < end; s++)
+		{
+			const int i = indices[s];
+			const Vec2i tile = grid.key_to_tile[i];
+			const Vec2f origin = grid.compactOrigin(tile.y, tile.x);
+			fits = fits && compactFits(particles.x[i], origin.x, inv_step.x) && compactFits(particles.y[i], origin.y, inv_step.y);
+			positions.x[s] = encodeCompact(particles.x[i], origin.x, inv_step.x);
+			positions.y[s] = encodeCompact(particles.y[i], origin.y, inv_step.y);
+		}
+		if (!fits)
+			compact_overflow.store(true, std::memory_order_relaxed);
+	});
+	//	Some particle has moved more than COMPACT_MARGIN cells since the grid update, so its value would
+	//	saturate and it would jump back towards its cell. The positions are untouched so far, relax on floats.
+	if (compact_overflow.load(std::memory_order_relaxed))
+		return false;
+
+	sweepTiles(team, [&](const Vec2i& tile) {
+		const CompactTileView view = grid.compactTileView(tile.x, tile.y);
+		int around = 0;
+		for (int cell = 0; cell < view.neighbour_count; cell++)
+			around += view.neighbours[cell].count;
+		visits += (double)view.own.count * around;
+		kernels.densityCompact(positions, view, c);
+	});
+
+	team.forEach(count, PARTICLE_CHUNK_SIZE, [&](int s) {
+		const int i = indices[s];
+		const Vec2i tile = grid.key_to_tile[i];
+		const Vec2f origin = grid.compactOrigin(tile.y, tile.x);
+		particles.x[i] = decodeCompact(positions.x[s], origin.x, step.x);
+		particles.y[i] = decodeCompact(positions.y[s], origin.y, step.y);
+	});
+	return true;
+}
+
+void Simulation::jacobiRelaxation(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const int count = particles.size();
+	const ParticleView view = particles.view();
+	double& visits = member_visits[team.index()];
+
+	team.single([&] {
+		pressure.resize(count);
+		pressure_near.resize(count);
+		jacobi_x.resize(count);
+		jacobi_y.resize(count);
+	});
+
+	//	Neither pass writes what the other tiles read, so the occupied cells need no colouring.
+	team.forEach(grid.occupied.size(), 1, [&](int t) {
+		const Vec2i tile = grid.occupied[t];
+		kernels.densityPressure(view, grid.tileView(tile.x, tile.y), c, pressure.data(), pressure_near.data());
+	});
+
+	team.forEach(grid.occupied.size(), 1, [&](int t) {
+		const Vec2i tile = grid.occupied[t];
+		const TileView neighbourhood = grid.tileView(tile.x, tile.y);
+		int around = 0;
+		for (int cell = 0; cell < neighbourhood.neighbour_count; cell++)
+			around += neighbourhood.neighbours[cell].count;
+		visits += (double)neighbourhood.own.count * around;
+		kernels.densityGather(view, neighbourhood, pressure.data(), pressure_near.data(), tuning.jacobi_weight, c,
+			jacobi_x.data(), jacobi_y.data());
+	});
+
+	team.single([&] {
+		particles.x.swap(jacobi_x);
+		particles.y.swap(jacobi_y);
+	});
+}
+
+void Simulation::adjustStrings(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const float h = c.h, h2 = c.h2;
+
+	const int N = particles.size();
+
+	team.forEach(N, PARTICLE_CHUNK_SIZE, [&](int i) {
+		const Vec2f pos = particles.pos(i);
+
+		std::vector<int> to_add;
+		to_add.reserve(8);
+
+		if (tuning.pair_list)
+		{
+			//	q was computed from the same predicted positions, so q < 1 is exactly r < h.
+			for (int n = neighbours.start[i]; n < neighbours.start[i + 1]; n++)
+			{
+				const NeighbourPair& pair = neighbours.pairs[n];
+				if (pair.j > i && pair.q < 1.0f && !springs.springExists(i, pair.j))
+					to_add.push_back(pair.j);
+			}
+		}
+		else
+		{
+			grid.forEachHalfNeighbour(i, [&](int neighbour_key) {
+				if (springs.springExists(std::min(i, neighbour_key), std::max(i, neighbour_key)))
+					return;
+				const Vec2f r_ij = particles.pos(neighbour_key) - pos;
+
+				if (r_ij.x * r_ij.x + r_ij.y * r_ij.y < h2)
+				{
+					to_add.push_back(neighbour_key);
+				}
+			});
+		}
+
+		std::lock_guard<std::mutex> lock(spring_mutex);
+		for (int j = 0; j < to_add.size(); j++)
+			springs.addSpring(std::min(i, to_add[j]), std::max(i, to_add[j]), h);
+	});
+
+	const int KEYS_SIZE = (int)springs.keys.size();
+	const int CHUNK_SIZE = tuning.spring_chunk;
+
+	team.single([&] { spring_lengths.assign(KEYS_SIZE, 0.0f); });
+
+	team.forRange(KEYS_SIZE, CHUNK_SIZE, [&](int begin, int end) {
+		kernels.springLengths(particles.view(), springs.keys.data() + begin, springs.arr.data(), end - begin,
+			springs.maxParticleAmount, c, spring_lengths.data() + begin);
+	});
+
+	team.single([&] {
+		std::vector<float>& Ls = spring_lengths;
+		for (int j = 0; j < KEYS_SIZE; j++)
+		{
+			springs.arr[springs.keys[j]] = Ls[j];
+		}
+
+		int idx = KEYS_SIZE - 1;
+		for (int j = 0; j <= idx; j++)
+		{
+			if (Ls[j] > h)
+			{
+				std::swap(springs.keys[j], springs.keys[idx]);
+				std::swap(Ls[j], Ls[idx]);
+				j--;
+				idx--;
+			}
+		}
+
+		for (int j = KEYS_SIZE - 1; j > idx; j--)
+		{
+			springs.arr[springs.keys[j]] = 0.0f;
+			springs.keys.pop_back();
+		}
+	});
+}
+
+void Simulation::applyStrings(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const int KEYS_SIZE = springs.keys.size();
+	const int BATCH_SIZE = tuning.spring_batch;
+
+	team.single([&] { spring_displacements.resize(KEYS_SIZE); });
+
+	//	All displacements come from the positions before the pass. A particle belongs to springs of several
+	//	batches, so they are applied by one member once every batch is done.
+	team.forRange(KEYS_SIZE, BATCH_SIZE, [&](int begin, int end) {
+		kernels.springDisplacements(particles.view(), springs.keys.data() + begin, springs.arr.data(), end - begin,
+			springs.maxParticleAmount, c, spring_displacements.data() + begin);
+	});
+
+	team.single([&] {
+		for (int j = 0; j < KEYS_SIZE; j++)
+		{
+			const std::pair<int, int> id = springs.reverseId(springs.keys[j]);
+			const Vec2f D = spring_displacements[j];
+			particles.x[id.first] -= D.x;
+			particles.y[id.first] -= D.y;
+			particles.x[id.second] += D.x;
+			particles.y[id.second] += D.y;
+		}
+	});
+}
+
+
+void Simulation::applyViscosity(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const PairView pairs = neighbours.view();
+	const ParticleView view = particles.view();
+
+	if (tuning.pair_list)
+	{
+		//	Every particle writes only its own values, so this is one work-shared loop instead of a sweep.
+		const int count = particles.size();
+		team.single([&] {
+			viscosity_vx.resize(count);
+			viscosity_vy.resize(count);
+		});
+		team.forRange(count, PAIR_CHUNK_SIZE, [&](int begin, int end) {
+			kernels.viscosityPairs(view, begin, end, pairs, c, viscosity_vx.data(), viscosity_vy.data());
+		});
+		team.single([&] {
+			particles.vx.swap(viscosity_vx);
+			particles.vy.swap(viscosity_vy);
+		});
+		return;
+	}
+
+	sweepTiles(team, [&](const Vec2i& tile) {
+		kernels.viscosityTile(view, grid.halfTileView(tile.x, tile.y), c);
+	});
+}
+
+void Simulation::integrateBegin(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const ParticleView view = particles.view();
+	const float dv_y = -conf::G * c.dt;
+	team.forRange(particles.size(), PARTICLE_CHUNK_SIZE, [&](int begin, int end) {
+		kernels.integrateBegin(view, begin, end, dv_y, c.dt);
+	});
+}
+
+void Simulation::integrateEnd(parallel::Team& team, const StepConstants& c)
+{
+	const KernelTable& kernels = cpu::kernels();
+	const ParticleView view = particles.view();
+	const int count = particles.size();
+	//	Same clamp as Particle::checkBounds, or none without walls.
+	const float infinity = std::numeric_limits<float>::infinity();
+	IntegrationBox box = { 0.0f, 0.0f, c.X, c.Y, grid.SIZE_PER_TILE.x, grid.SIZE_PER_TILE.y };
+	if (!config.bounded)
+		box.min_x = box.min_y = -infinity, box.max_x = box.max_y = infinity;
+
+	team.single([&] { step_tiles.resize(count); });
+	team.forRange(count, PARTICLE_CHUNK_SIZE, [&](int begin, int end) {
+		kernels.integrateEnd(view, begin, end, box, 1.0f / c.dt, step_tiles.data());
+	});
+	grid.update(team, particles, step_tiles.data());
+}
+
+bool Simulation::buildNeighbours(parallel::Team& team, const StepConstants& c)
+{
+	const float skin = tuning.verlet_skin * c.h;
+	const bool reuse = skin > 0.0f && neighbours.valid && neighbours.cutoff == c.h + skin
+		&& neighbours.maxDisplacement(team, particles) <= skin / 2;
+
+	if (reuse)
+		neighbours.refresh(team, particles, c.h);
+	else
+		neighbours.build(team, particles, grid, c.h, c.h + skin);
+	return !reuse;
+}
+
+void Simulation::reorderParticles(parallel::Team& team)
+{
+	const int N = particles.size();
+
+	team.single([&] {
+		std::vector<uint64_t> codes(N);
+		for (int i = 0; i < N; i++)
+		{
+			const Vec2i tile = grid.getKeyTile(i);
+			codes[i] = (static_cast<uint64_t>(mortonCode(tile.x, tile.y)) << 32) | static_cast<uint32_t>(i);
+		}
+		std::sort(codes.begin(), codes.end());
+
+		reorder_order.resize(N);
+		reorder_inverse.resize(N);
+		for (int n = 0; n < N; n++)
+		{
+			reorder_order[n] = static_cast<uint32_t>(codes[n]);
+			reorder_inverse[reorder_order[n]] = n;
+		}
+	});
+
+	particles.permute(team, reorder_order.data(), reorder_scratch);
+	team.single([&] {
+		springs.remap(reorder_inverse.data());
+		neighbours.invalidate();
+	});
+
+	grid.remap(team, reorder_order.data(), reorder_inverse.data(), particles);
+}
@@ -0,0 +1,240 @@
+#pragma once
+#include "Conf.hpp"
+#include "SimulationConfig.hpp"
+#include "Vector2.hpp"
+#include "Particle.hpp"
+#include "ParticleGrid.hpp"
+#include "ParticleStore.hpp"
+#include "ParticleSprings.hpp"
+#include "NeighbourList.hpp"
+#include "Util.hpp"
+#include "CollisionObjects.hpp"
+#include "Parallel.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+
+//	Time spent in each phase of the last update() call, in microseconds.
+struct StepTimings
+{
+	float viscosity = 0, velocity = 0, adjust_springs = 0, apply_springs = 0,
+		relaxation = 0, stickiness = 0, collisions = 0, bounds_update = 0, reorder = 0, neighbours = 0;
+	//	Not a time: 1 if the step rebuilt the neighbour list, so sums count rebuilds.
+	float neighbour_rebuilds = 0;
+	//	Part of viscosity and relaxation: average time a team member waited at the end of a colour for the
+	//	others to finish their tiles.
+	float tile_idle = 0;
+	//	Not a time: estimated bytes the relaxation sweep read and wrote, from the number of neighbours it
+	//	visited and the bytes each visit moves in the active mode.
+	float relaxation_bytes = 0;
+	//	Not a time: 1 if the step asked for compact relaxation and fell back to float positions.
+	float compact_fallbacks = 0;
+
+	StepTimings& operator+=(const StepTimings& other)
+	{
+		viscosity += other.viscosity;
+		velocity += other.velocity;
+		adjust_springs += other.adjust_springs;
+		apply_springs += other.apply_springs;
+		relaxation += other.relaxation;
+		stickiness += other.stickiness;
+		collisions += other.collisions;
+		bounds_update += other.bounds_update;
+		reorder += other.reorder;
+		neighbours += other.neighbours;
+		neighbour_rebuilds += other.neighbour_rebuilds;
+		tile_idle += other.tile_idle;
+		relaxation_bytes += other.relaxation_bytes;
+		compact_fallbacks += other.compact_fallbacks;
+		return *this;
+	}
+
+	float total() const
+	{
+		return viscosity + velocity + adjust_springs + apply_springs + relaxation + stickiness + collisions + bounds_update + reorder + neighbours;
+	}
+};
+
+//	Parallel granularity of a step. Apart from pair_list, compact and jacobi, any valid values give the same physics;
+//	autotune::tune picks the fastest ones for the machine and particle count.
+struct StepTuning
+{
+	static constexpr int MAX_SPRING_BATCH = 1024;
+
+	int spring_chunk = 400;		//	springs per springLengths work item
+	int spring_batch = 300;		//	springs per springDisplacements work item, at most MAX_SPRING_BATCH
+	int colour_stride = 3;		//	tiles of one colour are this many cells apart, at least 3
+	float cell_scale = 1.0f;	//	grid cell size in units of h, at least 1
+	GridLayout grid_layout = GridLayout::NESTED;
+	int reorder_interval = 0;	//	steps between Morton reorders of the particles, 0 never reorders
+	//	Find neighbours once per step, right after prediction, and share them between viscosity, springs
+	//	and relaxation. Viscosity then acts on the predicted positions rather than the previous ones, and
+	//	takes every impulse from the velocities before it instead of applying them one by one.
+	bool pair_list = false;
+	//	pair_list only: the list keeps candidates within h * (1 + verlet_skin) and is rebuilt once a particle
+	//	has moved half the skin, otherwise just refreshed. 0 rebuilds every step. Cells grow to fit the skin.
+	float verlet_skin = 0.0f;
+	//	Hand out each colour's tiles most expensive first, estimated from the occupancy of their
+	//	neighbourhood, instead of in random order.
+	bool cost_order = true;
+	//	Relax on a copy of the positions as 16-bit offsets from their cell, in the grid's cell order, which
+	//	quarters the bytes per neighbour visit at the cost of rounding positions to about 1 / 7000 of a cell
+	//	each step. Needs the index array of SORTED or HASHED, so a NESTED grid becomes SORTED. Ignored with
+	//	pair_list, which visits neighbours by particle index.
+	bool compact = false;
+	//	Relax every particle against a snapshot of the positions and the pressures of its neighbours in two
+	//	uncoloured passes, instead of moving neighbours in place tile by tile. Every tile is independent,
+	//	but each step only feels its neighbours' displacements from the previous step, so it is softer than
+	//	the default. Takes precedence over compact, ignored with pair_list.
+	bool jacobi = false;
+	//	jacobi only: fraction of the gathered displacement applied, in (0, 1]. Every particle moves at once,
+	//	so the full displacement overshoots; 0.5 keeps the dam scene stable up to dt = 1/20.
+	float jacobi_weight = 0.5f;
+
+	std::string describe() const
+	{
+		std::ostringstream out;
+		out << "spring_chunk=" << spring_chunk << " spring_batch=" << spring_batch << " colour_stride=" << colour_stride
+			<< " cell_scale=" << cell_scale << " reorder_interval=" << reorder_interval << " grid=" << gridLayoutName(grid_layout)
+			<< " pair_list=" << pair_list << " verlet_skin=" << verlet_skin << " cost_order=" << cost_order
+			<< " compact=" << compact << " jacobi=" << jacobi
+			<< " jacobi_weight=" << jacobi_weight;
+		return out.str();
+	}
+};
+
+//	Optional phases of a step. update() runs the step<> instantiation for the enabled set,
+//	so disabled phases are compiled out instead of being skipped at runtime.
+namespace features
+{
+	constexpr unsigned SPRINGS = 1 << 0;
+	constexpr unsigned VISCOSITY = 1 << 1;
+	constexpr unsigned STICKINESS = 1 << 2;
+	constexpr unsigned OBJECTS = 1 << 3;
+	constexpr unsigned COMBINATIONS = 1 << 4;
+
+	inline std::string describe(unsigned mask)
+	{
+		std::string result;
+		const char* names[] = { "springs", "viscosity", "stickiness", "objects" };
+		for (int i = 0; i < 4; i++)
+		{
+			if (mask & (1u << i))
+				result += (result.empty() ? "" : "|") + std::string(names[i]);
+		}
+		return result.empty() ? "none" : result;
+	}
+}
+
+class Simulation
+{
+public:
+	int n = 0;
+	SimulationConfig config;
+	ParticleStore particles;
+	std::vector<CollisionObject*> objects;
+	ParticleGrid grid = ParticleGrid(10, 10, Vec2f(config.X, config.Y));
+	ParticleSprings springs = ParticleSprings();
+	NeighbourList neighbours;
+	StepTimings timings;
+	StepTuning tuning;
+	unsigned active_features = 0;
+
+	Simulation(const SimulationConfig& config = SimulationConfig());
+
+	void deleteWater();
+	void createGrid();
+	//	Both return false if the springs no longer fit the grown particle capacity and were dropped, see
+	//	reserveSprings.
+	bool addParticle(Particle p);
+	//	Adds the particles inside the world in one pass over the grid and springs.
+	bool addParticles(const std::vector<Particle>& batch);
+	//	Removes the particles at indices by moving the last particles into their slots, so indices of other
+	//	particles change. Springs of removed particles are dropped.
+	void removeParticles(std::vector<int> indices);
+	//	Clamps the values into their valid ranges and rebuilds the grid if the cell size changed.
+	void setTuning(const StepTuning& tuning);
+
+	//	Advances the simulation by config.dt. Without room for the spring table, see reserveSprings, the step
+	//	runs without springs.
+	void update();
+	unsigned featureMask() const;
+	//	Allocates the spring table if config.k_spring enables springs. False if the particle capacity needs
+	//	a table over ParticleSprings::MAX_TABLE_BYTES or the allocation fails.
+	bool reserveSprings();
+
+	//	Runs on every member of the step's parallel region.
+	template <unsigned Features>
+	void step(parallel::Team& team, const StepConstants& c);
+
+	//	The phases assume their feature is enabled; step<> decides which ones run. Each one is called by
+	//	every member of the team and ends with a barrier.
+
+	void handleStickiness(parallel::Team& team, const StepConstants& c);
+	void applyCollisions(parallel::Team& team);
+	void doubleDensityRelaxation(parallel::Team& team, const StepConstants& c);
+	void adjustStrings(parallel::Team& team, const StepConstants& c);
+	void applyStrings(parallel::Team& team, const StepConstants& c);
+	void applyViscosity(parallel::Team& team, const StepConstants& c);
+	//	Gravity and prediction in one pass over the particles.
+	void integrateBegin(parallel::Team& team, const StepConstants& c);
+	//	Bounds, velocities and grid cells in one pass over the particles, then the grid update.
+	void integrateEnd(parallel::Team& team, const StepConstants& c);
+	//	Returns whether the list was rebuilt rather than refreshed.
+	bool buildNeighbours(parallel::Team& team, const StepConstants& c);
+	//	Permutes particles into Morton order of their cells and remaps the grid and springs to match.
+	void reorderParticles(parallel::Team& team);
+
+private:
+	//	Particles handed to the collide/stick kernels per parallel work item.
+	static constexpr int OBJECT_CHUNK_SIZE = 256;
+	//	Particles per work item for the cheap per-particle loops (gravity, integration, bounds).
+	static constexpr int PARTICLE_CHUNK_SIZE = 1024;
+	//	Particles per work item of the pair list viscosity, each with a row of some tens of pairs.
+	static constexpr int PAIR_CHUNK_SIZE = 256;
+
+	//	Scratch shared by the team members within a step.
+	std::vector<std::vector<Vec2i>> colour_tiles;
+	std::vector<float> spring_lengths;
+	//	applyStrings: displacement of every spring in springs.keys order.
+	std::vector<Vec2f> spring_displacements;
+	std::vector<ObjectView> object_views;
+	std::mutex spring_mutex;
+	std::vector<int> reorder_order, reorder_inverse;
+	std::vector<float> reorder_scratch;
+	//	Microseconds each member has waited for the others in this step's coloured sweeps.
+	std::vector<float> member_idle;
+	//	Neighbours each member has visited in this step's relaxation, for StepTimings::relaxation_bytes.
+	std::vector<double> member_visits;
+	//	Compact relaxation: slot s holds particle grid.indices[s], see CompactPositions.
+	std::vector<uint16_t> compact_x, compact_y;
+	//	Set while encoding if some particle does not fit its compact span.
+	std::atomic<bool> compact_overflow{ false };
+	//	Jacobi relaxation: per particle pressures and the relaxed positions, swapped into particles after.
+	std::vector<float> pressure, pressure_near, jacobi_x, jacobi_y;
+	//	Pair list viscosity: the new velocities, swapped into particles after.
+	std::vector<float> viscosity_vx, viscosity_vy;
+	//	Grid cell of every particle, written by integrateEnd for the grid update.
+	std::vector<Vec2i> step_tiles;
+
+	int steps_since_reorder = 0;
+	//	Set by update() so every team member agrees on whether this step reorders.
+	bool reorder_due = false;
+
+	std::vector<ObjectView> objectViews() const;
+	//	Buckets grid.occupied into colour_tiles by colour (colour_stride^2 of them, shuffled), so the 3x3
+	//	neighbourhoods of one colour never overlap. With cost_order each colour's tiles are sorted
+	//	by own * neighbourhood particle count instead, roughly the number of pairs a tile visits.
+	void colourTiles();
+	//	Calls body(tile) on every tile of colour_tiles, one colour after the other, and adds the time this
+	//	member waited at the end of each colour to member_idle.
+	template <class F>
+	void sweepTiles(parallel::Team& team, F&& body);
+	//	doubleDensityRelaxation with tuning.compact: encodes the positions, sweeps the tiles on the compact
+	//	copy and decodes it back. Returns false without relaxing if some particle does not fit its span.
+	bool compactRelaxation(parallel::Team& team, const StepConstants& c);
+	//	doubleDensityRelaxation with tuning.jacobi.
+	void jacobiRelaxation(parallel::Team& team, const StepConstants& c);
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <string>
+
+//	Physics parameters owned by one Simulation. The app's sliders edit these directly.
+struct SimulationConfig
+{
+	float dt = 1.0f / 60;
+	float X = 40.0f, Y = 40.0f * (700.0f / 1280.0f);							//	world size
+
+	float particle_radius = std::min(X, Y) / 200.0f;
+	float h = std::min(X, Y) / 45.0f;										//	interaction radius
+	float k = 5.0f, k_near = 8.0f * 10, k_spring = 0.0f, k_stick = 5.0f;	//	stiffness / near stiffness
+	float density_rest = 10.0f;												//	rest density
+	float yield_ratio = 0.2f, plasticity = 40.0f;							//	yield ratio / plasticity
+	float alpha_viscosity = 4.0f, beta_viscosity = 0.0f;
+	float stickness_distance = h;
+	//	Keep particles inside [0, X) x [0, Y). Without walls the grid switches to the hashed layout.
+	bool bounded = true;
+
+	//	Looks a parameter up by its field name, returns nullptr if there is none.
+	float* parameter(const std::string& name)
+	{
+		struct Entry { const char* name; float SimulationConfig::* field; };
+		static const Entry entries[] = {
+			{ "dt", &SimulationConfig::dt }, { "X", &SimulationConfig::X }, { "Y", &SimulationConfig::Y },
+			{ "particle_radius", &SimulationConfig::particle_radius }, { "h", &SimulationConfig::h },
+			{ "k", &SimulationConfig::k }, { "k_near", &SimulationConfig::k_near },
+			{ "k_spring", &SimulationConfig::k_spring }, { "k_stick", &SimulationConfig::k_stick },
+			{ "density_rest", &SimulationConfig::density_rest }, { "yield_ratio", &SimulationConfig::yield_ratio },
+			{ "plasticity", &SimulationConfig::plasticity }, { "alpha_viscosity", &SimulationConfig::alpha_viscosity },
+			{ "beta_viscosity", &SimulationConfig::beta_viscosity }, { "stickness_distance", &SimulationConfig::stickness_distance }
+		};
+		for (const Entry& entry : entries)
+		{
+			if (name == entry.name)
+				return &(this->*entry.field);
+		}
+		return nullptr;
+	}
+};
+
+//	Values derived from the config once per step so the kernels can keep them in locals.
+struct StepConstants
+{
+	float dt, dt2;
+	float X, Y;
+	float h, inv_h, h2;
+	float k, k_near, density_rest;
+	float k_spring, yield_ratio, plasticity;
+	float alpha_viscosity, beta_viscosity;
+	float k_stick, stickness_distance;
+
+	StepConstants(const SimulationConfig& config) :
+		dt(config.dt), dt2(config.dt * config.dt),
+		X(config.X), Y(config.Y),
+		h(config.h), inv_h(1.0f / config.h), h2(config.h * config.h),
+		k(config.k), k_near(config.k_near), density_rest(config.density_rest),
+		k_spring(config.k_spring), yield_ratio(config.yield_ratio), plasticity(config.plasticity),
+		alpha_viscosity(config.alpha_viscosity), beta_viscosity(config.beta_viscosity),
+		k_stick(config.k_stick), stickness_distance(config.stickness_distance)
+	{
+	}
+};
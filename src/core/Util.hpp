@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <math.h>
+#include "Vector2.hpp"
+
+inline float getLen(Vec2f vec)
+{
+	return sqrt(vec.x * vec.x + vec.y * vec.y);
+}
+
+inline float randFloat(float low, float high) {
+	return low + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (high - low)));
+}
+
+//	Z-order index of cell (x, y): the bits of x and y interleaved, so nearby cells get nearby codes.
+inline uint32_t mortonCode(uint32_t x, uint32_t y)
+{
+	auto spread = [](uint32_t v) {
+		v &= 0xffff;
+		v = (v | (v << 8)) & 0x00ff00ff;
+		v = (v | (v << 4)) & 0x0f0f0f0f;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	};
+	return spread(x) | (spread(y) << 1);
+}
+
+//	Wall clock for timing simulation phases; restart() returns the elapsed microseconds.
+class Clock
+{
+public:
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	float restart()
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const float elapsed = std::chrono::duration<float, std::micro>(now - start).count();
+		start = now;
+		return elapsed;
+	}
+};
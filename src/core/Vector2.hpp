@@ -0,0 +1,99 @@
+#pragma once
+
+//	Minimal 2D vector used by the physics core so it does not depend on SFML.
+template <typename T>
+class Vector2
+{
+public:
+	T x, y;
+
+	Vector2() : x(0), y(0) {}
+
+	Vector2(T x, T y) : x(x), y(y) {}
+
+	template <typename U>
+	explicit Vector2(const Vector2<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+};
+
+template <typename T>
+inline Vector2<T> operator-(const Vector2<T>& v)
+{
+	return Vector2<T>(-v.x, -v.y);
+}
+
+template <typename T>
+inline Vector2<T>& operator+=(Vector2<T>& a, const Vector2<T>& b)
+{
+	a.x += b.x;
+	a.y += b.y;
+	return a;
+}
+
+template <typename T>
+inline Vector2<T>& operator-=(Vector2<T>& a, const Vector2<T>& b)
+{
+	a.x -= b.x;
+	a.y -= b.y;
+	return a;
+}
+
+template <typename T>
+inline Vector2<T> operator+(const Vector2<T>& a, const Vector2<T>& b)
+{
+	return Vector2<T>(a.x + b.x, a.y + b.y);
+}
+
+template <typename T>
+inline Vector2<T> operator-(const Vector2<T>& a, const Vector2<T>& b)
+{
+	return Vector2<T>(a.x - b.x, a.y - b.y);
+}
+
+template <typename T>
+inline Vector2<T> operator*(const Vector2<T>& v, T s)
+{
+	return Vector2<T>(v.x * s, v.y * s);
+}
+
+template <typename T>
+inline Vector2<T> operator*(T s, const Vector2<T>& v)
+{
+	return Vector2<T>(v.x * s, v.y * s);
+}
+
+template <typename T>
+inline Vector2<T>& operator*=(Vector2<T>& v, T s)
+{
+	v.x *= s;
+	v.y *= s;
+	return v;
+}
+
+template <typename T>
+inline Vector2<T> operator/(const Vector2<T>& v, T s)
+{
+	return Vector2<T>(v.x / s, v.y / s);
+}
+
+template <typename T>
+inline Vector2<T>& operator/=(Vector2<T>& v, T s)
+{
+	v.x /= s;
+	v.y /= s;
+	return v;
+}
+
+template <typename T>
+inline bool operator==(const Vector2<T>& a, const Vector2<T>& b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+template <typename T>
+inline bool operator!=(const Vector2<T>& a, const Vector2<T>& b)
+{
+	return !(a == b);
+}
+
+typedef Vector2<float> Vec2f;
+typedef Vector2<int> Vec2i;
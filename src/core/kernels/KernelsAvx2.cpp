@@ -0,0 +1,4 @@
+//	Kernel variant built with the avx2 flags set in CMakeLists.txt.
+#define FLUID_KERNEL_NAMESPACE kernels_avx2
+#define FLUID_KERNEL_NAME "avx2"
+#include "KernelsImpl.inl"
@@ -0,0 +1,4 @@
+//	Kernel variant built with the avx512 flags set in CMakeLists.txt.
+#define FLUID_KERNEL_NAMESPACE kernels_avx512
+#define FLUID_KERNEL_NAME "avx512"
+#include "KernelsImpl.inl"
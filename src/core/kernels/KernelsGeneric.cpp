@@ -0,0 +1,4 @@
+//	Baseline kernel variant, built with the default flags of the target.
+#define FLUID_KERNEL_NAMESPACE kernels_generic
+#define FLUID_KERNEL_NAME "generic"
+#include "KernelsImpl.inl"
@@ -0,0 +1,1020 @@
+//	Hot kernels, included once per instruction set by the Kernels*.cpp files with FLUID_KERNEL_NAMESPACE
+//	and FLUID_KERNEL_NAME defined. Those files are built with different -m flags, so this code must not
+//	call inline functions or templates with external linkage (Vector2 operators, getLen, std::vector, ...):
+//	the linker would keep one copy of each and could pick the widest one. Stick to plain data, the C
+//	math functions, the static helpers of Kernels.hpp and helpers defined inside the namespace below.
+
+#include "../CpuDispatch.hpp"
+#include <math.h>
+#include <stdlib.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace FLUID_KERNEL_NAMESPACE
+{
+	namespace
+	{
+		//	Direction used when two particles sit exactly on top of each other.
+		void randomUnit(float& x, float& y)
+		{
+			const float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * 3.1415f;
+			x = cosf(angle);
+			y = sinf(angle);
+		}
+
+#if defined(__AVX2__)
+		//	Index of the lowest set bit of a non-zero lane mask.
+		int lowestLane(unsigned lanes)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, lanes);
+			return index;
+#else
+			return __builtin_ctz(lanes);
+#endif
+		}
+#endif
+
+#if defined(__AVX512F__)
+		//	The few vector operations the SIMD kernels need, over 16 lanes with mask registers.
+		struct Simd
+		{
+			static constexpr int WIDTH = 16;
+			typedef __m512 Float;
+			typedef __m512i Int;
+			typedef __mmask16 Mask;
+
+			static Float set(float v) { return _mm512_set1_ps(v); }
+			static Float zero() { return _mm512_setzero_ps(); }
+			static Int loadKeys(const int* p) { return _mm512_loadu_si512(p); }
+			//	0, stride, 2 * stride, ...
+			static Int laneOffsets(int stride)
+			{
+				return _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride));
+			}
+			static Int gatherKeys(const int* base, Int offsets) { return _mm512_i32gather_epi32(offsets, base, 4); }
+			static Float load(const float* p) { return _mm512_loadu_ps(p); }
+			static void store(float* p, Float a) { _mm512_storeu_ps(p, a); }
+			static void storeKeys(int* p, Int a) { _mm512_storeu_si512(p, a); }
+			static Float gather(const float* base, Int keys) { return _mm512_i32gather_ps(keys, base, 4); }
+			static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+			static Float sqrt(Float a) { return _mm512_sqrt_ps(a); }
+			static Float min(Float a, Float b) { return _mm512_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm512_max_ps(a, b); }
+			static Int floorToInt(Float a) { return _mm512_cvttps_epi32(_mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)); }
+			static Mask less(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static Mask equal(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+			static Mask notKey(Int keys, int key) { return _mm512_cmpneq_epi32_mask(keys, _mm512_set1_epi32(key)); }
+			static Mask both(Mask a, Mask b) { return a & b; }
+			static Mask without(Mask a, Mask b) { return a & ~b; }
+			static unsigned bits(Mask m) { return m; }
+			//	a where m is set, 0 elsewhere.
+			static Float select(Mask m, Float a) { return _mm512_maskz_mov_ps(m, a); }
+			//	a where m is set, b elsewhere.
+			static Float choose(Mask m, Float a, Float b) { return _mm512_mask_blend_ps(m, b, a); }
+			static float sum(Float a) { return _mm512_reduce_add_ps(a); }
+			//	base[keys[l]] = values[l] for the lanes of m. The keys must be distinct.
+			static void scatter(float* base, Int keys, Float values, Mask m) { _mm512_mask_i32scatter_ps(base, m, keys, values, 4); }
+		};
+#elif defined(__AVX2__)
+		//	The few vector operations the SIMD kernels need, over 8 lanes with all-ones lanes as masks.
+		struct Simd
+		{
+			static constexpr int WIDTH = 8;
+			typedef __m256 Float;
+			typedef __m256i Int;
+			typedef __m256 Mask;
+
+			static Float set(float v) { return _mm256_set1_ps(v); }
+			static Float zero() { return _mm256_setzero_ps(); }
+			static Int loadKeys(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			static Int laneOffsets(int stride) { return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride)); }
+			static Int gatherKeys(const int* base, Int offsets) { return _mm256_i32gather_epi32(base, offsets, 4); }
+			static Float load(const float* p) { return _mm256_loadu_ps(p); }
+			static void store(float* p, Float a) { _mm256_storeu_ps(p, a); }
+			static void storeKeys(int* p, Int a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+			static Float gather(const float* base, Int keys) { return _mm256_i32gather_ps(base, keys, 4); }
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+			static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+			static Int floorToInt(Float a) { return _mm256_cvttps_epi32(_mm256_floor_ps(a)); }
+			static Mask less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static Mask equal(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+			static Mask notKey(Int keys, int key)
+			{
+				return _mm256_xor_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(keys, _mm256_set1_epi32(key))),
+					_mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+			}
+			static Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+			static Mask without(Mask a, Mask b) { return _mm256_andnot_ps(b, a); }
+			static unsigned bits(Mask m) { return _mm256_movemask_ps(m); }
+			static Float select(Mask m, Float a) { return _mm256_and_ps(m, a); }
+			static Float choose(Mask m, Float a, Float b) { return _mm256_blendv_ps(b, a, m); }
+			static float sum(Float a)
+			{
+				__m128 half = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+				half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+				half = _mm_add_ss(half, _mm_movehdup_ps(half));
+				return _mm_cvtss_f32(half);
+			}
+			static void scatter(float* base, Int keys, Float values, Mask m)
+			{
+				alignas(32) int key[WIDTH];
+				alignas(32) float value[WIDTH];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(key), keys);
+				_mm256_store_ps(value, values);
+				for (unsigned lanes = bits(m); lanes != 0; lanes &= lanes - 1)
+				{
+					const int l = lowestLane(lanes);
+					base[key[l]] = value[l];
+				}
+			}
+		};
+#endif
+
+		//	Calls f(i, j) once for every unordered pair of particles in tile's half stencil.
+		template <class F>
+		void forEachHalfPair(const HalfTileView& tile, F f)
+		{
+			for (int own = 0; own < tile.own.count; own++)
+			{
+				const int i = tile.own.keys[own];
+				for (int n = 0; n < tile.own.count; n++)
+				{
+					if (tile.own.keys[n] > i)
+						f(i, tile.own.keys[n]);
+				}
+				for (int cell = 0; cell < tile.forward_count; cell++)
+				{
+					const CellSpan span = tile.forward[cell];
+					for (int n = 0; n < span.count; n++)
+						f(i, span.keys[n]);
+				}
+			}
+		}
+
+#if defined(__AVX2__)
+		//	Keys of a tile's whole neighbourhood in one array, so the vector loops run over full lanes and leave
+		//	one scalar tail per particle instead of one per cell. The array is the thread's cpu::scratchKeys.
+		int gatherCandidates(const TileView& tile, const int*& candidates)
+		{
+			int total = 0;
+			for (int cell = 0; cell < tile.neighbour_count; cell++)
+				total += tile.neighbours[cell].count;
+			int* out = cpu::scratchKeys(total);
+			candidates = out;
+			for (int cell = 0; cell < tile.neighbour_count; cell++)
+			{
+				const CellSpan span = tile.neighbours[cell];
+				for (int n = 0; n < span.count; n++)
+					*out++ = span.keys[n];
+			}
+			return total;
+		}
+
+		//	densityTile over Simd::WIDTH neighbour candidates at a time, with a scalar loop for the last few.
+		//	Candidates are masked rather than branched on, and since the candidates of one own particle are
+		//	distinct their updates are scattered without conflicts. The rare pairs at distance 0 go through the
+		//	scalar code for their random direction. Sums are taken in a different order, so results match
+		//	the scalar kernel within float rounding.
+		void densityTile(const ParticleView& particles, const TileView& tile, const StepConstants& c)
+		{
+			typedef Simd::Float Float;
+			typedef Simd::Mask Mask;
+			const int W = Simd::WIDTH;
+			const float h2 = c.h2, inv_h = c.inv_h, dt2_half = c.dt2 / 2.0f;
+			const float k = c.k, k_near = c.k_near, density_rest = c.density_rest;
+			float* x = particles.x;
+			float* y = particles.y;
+			const Float h2_v = Simd::set(h2), inv_h_v = Simd::set(inv_h), one = Simd::set(1.0f), zero = Simd::zero();
+			const int* candidates;
+			const int candidate_count = gatherCandidates(tile, candidates);
+
+			for (int own = 0; own < tile.own.count; own++)
+			{
+				const int i = tile.own.keys[own];
+				const float xi = x[i], yi = y[i];
+				const Float xi_v = Simd::set(xi), yi_v = Simd::set(yi);
+				Float density_v = zero, density_near_v = zero;
+				float density = 0, density_near = 0;
+
+				int n = 0;
+				for (; n + W <= candidate_count; n += W)
+				{
+					const Simd::Int keys = Simd::loadKeys(candidates + n);
+					const Float rx = Simd::sub(Simd::gather(x, keys), xi_v);
+					const Float ry = Simd::sub(Simd::gather(y, keys), yi_v);
+					const Float r2 = Simd::add(Simd::mul(rx, rx), Simd::mul(ry, ry));
+					const Mask near = Simd::both(Simd::less(r2, h2_v), Simd::notKey(keys, i));
+					const Float one_minus_q = Simd::sub(one, Simd::mul(Simd::sqrt(r2), inv_h_v));
+					const Float temp = Simd::select(near, Simd::mul(one_minus_q, one_minus_q));
+					density_v = Simd::add(density_v, temp);
+					density_near_v = Simd::add(density_near_v, Simd::mul(temp, one_minus_q));
+				}
+				for (; n < candidate_count; n++)
+				{
+					const int neighbour_key = candidates[n];
+					if (neighbour_key == i)
+						continue;
+					const float rx = x[neighbour_key] - xi;
+					const float ry = y[neighbour_key] - yi;
+					const float r2 = rx * rx + ry * ry;
+					if (r2 < h2)
+					{
+						const float q = sqrtf(r2) * inv_h;
+						const float temp = (1 - q) * (1 - q);
+						density += temp;
+						density_near += temp * (1 - q);
+					}
+				}
+				density += Simd::sum(density_v);
+				density_near += Simd::sum(density_near_v);
+
+				const float P = k * (density - density_rest);
+				const float P_near = k_near * density_near;
+				const Float P_v = Simd::set(P), P_near_v = Simd::set(P_near), dt2_half_v = Simd::set(dt2_half);
+
+				float dx = 0.0f, dy = 0.0f;
+				Float dx_v = zero, dy_v = zero;
+
+				//	Moves neighbour_key away from i, scalar like the generic kernel.
+				auto push = [&](int neighbour_key) {
+					const float rx = x[neighbour_key] - xi;
+					const float ry = y[neighbour_key] - yi;
+					const float r2 = rx * rx + ry * ry;
+					if (r2 < h2)
+					{
+						const float r = sqrtf(r2);
+						const float q = r * inv_h;
+						const float D = dt2_half * (1 - q) * (P + P_near * (1 - q));
+						float ux = rx / r, uy = ry / r;
+						if (r == 0.0f)
+							randomUnit(ux, uy);
+
+						x[neighbour_key] += D * ux;
+						y[neighbour_key] += D * uy;
+						dx -= D * ux;
+						dy -= D * uy;
+					}
+				};
+
+				for (n = 0; n + W <= candidate_count; n += W)
+				{
+					const Simd::Int keys = Simd::loadKeys(candidates + n);
+					const Float xn = Simd::gather(x, keys), yn = Simd::gather(y, keys);
+					const Float rx = Simd::sub(xn, xi_v), ry = Simd::sub(yn, yi_v);
+					const Float r2 = Simd::add(Simd::mul(rx, rx), Simd::mul(ry, ry));
+					const Mask near = Simd::both(Simd::less(r2, h2_v), Simd::notKey(keys, i));
+					const Mask coincident = Simd::both(near, Simd::equal(r2, zero));
+					const Mask active = Simd::without(near, coincident);
+
+					const Float r = Simd::sqrt(r2);
+					const Float one_minus_q = Simd::sub(one, Simd::mul(r, inv_h_v));
+					const Float D = Simd::mul(Simd::mul(dt2_half_v, one_minus_q), Simd::add(P_v, Simd::mul(P_near_v, one_minus_q)));
+					const Float move_x = Simd::select(active, Simd::mul(D, Simd::div(rx, r)));
+					const Float move_y = Simd::select(active, Simd::mul(D, Simd::div(ry, r)));
+
+					Simd::scatter(x, keys, Simd::add(xn, move_x), active);
+					Simd::scatter(y, keys, Simd::add(yn, move_y), active);
+					dx_v = Simd::sub(dx_v, move_x);
+					dy_v = Simd::sub(dy_v, move_y);
+
+					for (unsigned lanes = Simd::bits(coincident); lanes != 0; lanes &= lanes - 1)
+						push(candidates[n + lowestLane(lanes)]);
+				}
+				for (; n < candidate_count; n++)
+				{
+					if (candidates[n] != i)
+						push(candidates[n]);
+				}
+
+				x[i] += dx + Simd::sum(dx_v);
+				y[i] += dy + Simd::sum(dy_v);
+			}
+		}
+#else
+		void densityTile(const ParticleView& particles, const TileView& tile, const StepConstants& c)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h, dt2_half = c.dt2 / 2.0f;
+			const float k = c.k, k_near = c.k_near, density_rest = c.density_rest;
+			float* x = particles.x;
+			float* y = particles.y;
+
+			for (int own = 0; own < tile.own.count; own++)
+			{
+				const int i = tile.own.keys[own];
+				const float xi = x[i], yi = y[i];
+				float density = 0, density_near = 0;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CellSpan span = tile.neighbours[cell];
+					for (int n = 0; n < span.count; n++)
+					{
+						const int neighbour_key = span.keys[n];
+						if (neighbour_key == i)
+							continue;
+						const float rx = x[neighbour_key] - xi;
+						const float ry = y[neighbour_key] - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float q = sqrtf(r2) * inv_h;
+							const float temp = (1 - q) * (1 - q);
+							density += temp;
+							density_near += temp * (1 - q);
+						}
+					}
+				}
+
+				const float P = k * (density - density_rest);
+				const float P_near = k_near * density_near;
+
+				float dx = 0.0f, dy = 0.0f;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CellSpan span = tile.neighbours[cell];
+					for (int n = 0; n < span.count; n++)
+					{
+						const int neighbour_key = span.keys[n];
+						if (neighbour_key == i)
+							continue;
+						const float rx = x[neighbour_key] - xi;
+						const float ry = y[neighbour_key] - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float r = sqrtf(r2);
+							const float q = r * inv_h;
+							const float D = dt2_half * (1 - q) * (P + P_near * (1 - q));
+							float ux = rx / r, uy = ry / r;
+							if (r == 0.0f)
+								randomUnit(ux, uy);
+
+							x[neighbour_key] += D * ux;
+							y[neighbour_key] += D * uy;
+							dx -= D * ux;
+							dy -= D * uy;
+						}
+					}
+				}
+
+				x[i] += dx;
+				y[i] += dy;
+			}
+		}
+#endif
+
+		void densityCompact(const CompactPositions& positions, const CompactTileView& tile, const StepConstants& c)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h, dt2_half = c.dt2 / 2.0f;
+			const float k = c.k, k_near = c.k_near, density_rest = c.density_rest;
+			const float step_x = positions.step_x, step_y = positions.step_y;
+			const float inv_step_x = positions.inv_step_x, inv_step_y = positions.inv_step_y;
+			uint16_t* x = positions.x;
+			uint16_t* y = positions.y;
+			const CompactSpan own_span = tile.own;
+
+			for (int own = 0; own < own_span.count; own++)
+			{
+				const int i = own_span.begin + own;
+				const float xi = decodeCompact(x[i], own_span.origin_x, step_x);
+				const float yi = decodeCompact(y[i], own_span.origin_y, step_y);
+				float density = 0, density_near = 0;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CompactSpan span = tile.neighbours[cell];
+					for (int n = span.begin; n < span.begin + span.count; n++)
+					{
+						if (n == i)
+							continue;
+						const float rx = decodeCompact(x[n], span.origin_x, step_x) - xi;
+						const float ry = decodeCompact(y[n], span.origin_y, step_y) - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float q = sqrtf(r2) * inv_h;
+							const float temp = (1 - q) * (1 - q);
+							density += temp;
+							density_near += temp * (1 - q);
+						}
+					}
+				}
+
+				const float P = k * (density - density_rest);
+				const float P_near = k_near * density_near;
+
+				float dx = 0.0f, dy = 0.0f;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CompactSpan span = tile.neighbours[cell];
+					for (int n = span.begin; n < span.begin + span.count; n++)
+					{
+						if (n == i)
+							continue;
+						const float xn = decodeCompact(x[n], span.origin_x, step_x);
+						const float yn = decodeCompact(y[n], span.origin_y, step_y);
+						const float rx = xn - xi;
+						const float ry = yn - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float r = sqrtf(r2);
+							const float q = r * inv_h;
+							const float D = dt2_half * (1 - q) * (P + P_near * (1 - q));
+							float ux = rx / r, uy = ry / r;
+							if (r == 0.0f)
+								randomUnit(ux, uy);
+
+							x[n] = encodeCompact(xn + D * ux, span.origin_x, inv_step_x);
+							y[n] = encodeCompact(yn + D * uy, span.origin_y, inv_step_y);
+							dx -= D * ux;
+							dy -= D * uy;
+						}
+					}
+				}
+
+				//	Neighbour updates of this pass never touch i, so xi is still its value.
+				x[i] = encodeCompact(xi + dx, own_span.origin_x, inv_step_x);
+				y[i] = encodeCompact(yi + dy, own_span.origin_y, inv_step_y);
+			}
+		}
+
+		void densityPressure(const ParticleView& particles, const TileView& tile, const StepConstants& c,
+			float* pressure_out, float* pressure_near_out)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h;
+			const float k = c.k, k_near = c.k_near, density_rest = c.density_rest;
+			const float* x = particles.x;
+			const float* y = particles.y;
+
+			for (int own = 0; own < tile.own.count; own++)
+			{
+				const int i = tile.own.keys[own];
+				const float xi = x[i], yi = y[i];
+				float density = 0, density_near = 0;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CellSpan span = tile.neighbours[cell];
+					for (int n = 0; n < span.count; n++)
+					{
+						const int neighbour_key = span.keys[n];
+						if (neighbour_key == i)
+							continue;
+						const float rx = x[neighbour_key] - xi;
+						const float ry = y[neighbour_key] - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float q = sqrtf(r2) * inv_h;
+							const float temp = (1 - q) * (1 - q);
+							density += temp;
+							density_near += temp * (1 - q);
+						}
+					}
+				}
+
+				pressure_out[i] = k * (density - density_rest);
+				pressure_near_out[i] = k_near * density_near;
+			}
+		}
+
+		//	Gauss-Seidel moves i by -D_i * u_ij and j by +D_i * u_ij when it visits i, and the other way round
+		//	when it visits j, so i gathers -(D_i + D_j) * u_ij from each neighbour.
+		void densityGather(const ParticleView& particles, const TileView& tile, const float* pressure,
+			const float* pressure_near, float weight, const StepConstants& c, float* x_out, float* y_out)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h, dt2_half = c.dt2 / 2.0f;
+			const float* x = particles.x;
+			const float* y = particles.y;
+
+			for (int own = 0; own < tile.own.count; own++)
+			{
+				const int i = tile.own.keys[own];
+				const float xi = x[i], yi = y[i];
+				const float P = pressure[i], P_near = pressure_near[i];
+				float dx = 0.0f, dy = 0.0f;
+
+				for (int cell = 0; cell < tile.neighbour_count; cell++)
+				{
+					const CellSpan span = tile.neighbours[cell];
+					for (int n = 0; n < span.count; n++)
+					{
+						const int neighbour_key = span.keys[n];
+						if (neighbour_key == i)
+							continue;
+						const float rx = x[neighbour_key] - xi;
+						const float ry = y[neighbour_key] - yi;
+						const float r2 = rx * rx + ry * ry;
+						if (r2 < h2)
+						{
+							const float r = sqrtf(r2);
+							const float q = r * inv_h;
+							const float D = dt2_half * (1 - q) * (P + pressure[neighbour_key]
+								+ (P_near + pressure_near[neighbour_key]) * (1 - q));
+							//	Both sides of a coincident pair must agree on the direction, so no random one here.
+							float ux = 1.0f, uy = 0.0f;
+							if (r > 0.0f)
+							{
+								ux = rx / r;
+								uy = ry / r;
+							}
+							else if (neighbour_key < i)
+							{
+								ux = -1.0f;
+							}
+							dx -= D * ux;
+							dy -= D * uy;
+						}
+					}
+				}
+
+				x_out[i] = xi + weight * dx;
+				y_out[i] = yi + weight * dy;
+			}
+		}
+
+		void viscosityTile(const ParticleView& particles, const HalfTileView& tile, const StepConstants& c)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h, dt_half = c.dt / 2.0f;
+			const float alpha = c.alpha_viscosity, beta = c.beta_viscosity;
+			const float* x = particles.x;
+			const float* y = particles.y;
+			float* vx = particles.vx;
+			float* vy = particles.vy;
+
+			forEachHalfPair(tile, [&](int i, int j) {
+				const float rx = x[j] - x[i];
+				const float ry = y[j] - y[i];
+				const float r2 = rx * rx + ry * ry;
+				if (r2 < h2 && r2 > 0)
+				{
+					const float r = sqrtf(r2);
+					const float q = r * inv_h;
+					const float ux = rx / r, uy = ry / r;
+
+					const float u = (vx[i] - vx[j]) * ux + (vy[i] - vy[j]) * uy;
+					if (u > 0)
+					{
+						const float I = dt_half * (1 - q) * (alpha * u + beta * u * u);
+						vx[i] -= I * ux;
+						vy[i] -= I * uy;
+						vx[j] += I * ux;
+						vy[j] += I * uy;
+					}
+				}
+			});
+		}
+
+		void densityPairs(const ParticleView& particles, CellSpan own, const PairView& pairs, const StepConstants& c)
+		{
+			const float h2 = c.h2, inv_h = c.inv_h, dt2_half = c.dt2 / 2.0f;
+			const float k = c.k, k_near = c.k_near, density_rest = c.density_rest;
+			float* x = particles.x;
+			float* y = particles.y;
+
+			for (int o = 0; o < own.count; o++)
+			{
+				const int i = own.keys[o];
+				const float xi = x[i], yi = y[i];
+				const NeighbourPair* begin = pairs.pairs + pairs.start[i];
+				const NeighbourPair* end = pairs.pairs + pairs.start[i + 1];
+				float density = 0, density_near = 0;
+
+				for (const NeighbourPair* pair = begin; pair != end; pair++)
+				{
+					const float rx = x[pair->j] - xi;
+					const float ry = y[pair->j] - yi;
+					const float r2 = rx * rx + ry * ry;
+					if (r2 < h2)
+					{
+						const float q = sqrtf(r2) * inv_h;
+						const float temp = (1 - q) * (1 - q);
+						density += temp;
+						density_near += temp * (1 - q);
+					}
+				}
+
+				const float P = k * (density - density_rest);
+				const float P_near = k_near * density_near;
+
+				float dx = 0.0f, dy = 0.0f;
+
+				for (const NeighbourPair* pair = begin; pair != end; pair++)
+				{
+					const int j = pair->j;
+					const float rx = x[j] - xi;
+					const float ry = y[j] - yi;
+					const float r2 = rx * rx + ry * ry;
+					if (r2 < h2)
+					{
+						const float r = sqrtf(r2);
+						const float q = r * inv_h;
+						const float D = dt2_half * (1 - q) * (P + P_near * (1 - q));
+						float ux = rx / r, uy = ry / r;
+						if (r == 0.0f)
+							randomUnit(ux, uy);
+
+						x[j] += D * ux;
+						y[j] += D * uy;
+						dx -= D * ux;
+						dy -= D * uy;
+					}
+				}
+
+				x[i] += dx;
+				y[i] += dy;
+			}
+		}
+
+#if defined(__AVX2__)
+		//	viscosityPairs over Simd::WIDTH pairs of a row at a time, with a scalar loop for the last few. The
+		//	fields of the pairs are gathered with a stride of 4 floats, and the q and u > 0 tests become masks.
+		void viscosityPairs(const ParticleView& particles, int begin, int end, const PairView& pairs, const StepConstants& c,
+			float* vx_out, float* vy_out)
+		{
+			static_assert(sizeof(NeighbourPair) == 4 * sizeof(float), "viscosityPairs gathers NeighbourPair as 4 floats");
+			typedef Simd::Float Float;
+			typedef Simd::Mask Mask;
+			const int W = Simd::WIDTH;
+			const float dt = c.dt, dt_half = c.dt / 2.0f;
+			const float alpha = c.alpha_viscosity, beta = c.beta_viscosity;
+			const float* vx = particles.vx;
+			const float* vy = particles.vy;
+			const Simd::Int fields = Simd::laneOffsets(4);
+			const Float zero = Simd::zero(), one = Simd::set(1.0f);
+			const Float dt_half_v = Simd::set(dt_half), alpha_v = Simd::set(alpha), beta_v = Simd::set(beta);
+
+			for (int i = begin; i < end; i++)
+			{
+				const int row_end = pairs.start[i + 1];
+				const Float vxi = Simd::set(vx[i]), vyi = Simd::set(vy[i]);
+				Float dvx_v = zero, dvy_v = zero;
+				float dvx = 0.0f, dvy = 0.0f;
+
+				int n = pairs.start[i];
+				for (; n + W <= row_end; n += W)
+				{
+					const float* row = reinterpret_cast<const float*>(pairs.pairs + n);
+					const Simd::Int j = Simd::gatherKeys(reinterpret_cast<const int*>(row), fields);
+					const Float q = Simd::gather(row + 1, fields);
+					const Float ux = Simd::gather(row + 2, fields), uy = Simd::gather(row + 3, fields);
+
+					const Float u = Simd::add(Simd::mul(Simd::sub(vxi, Simd::gather(vx, j)), ux),
+						Simd::mul(Simd::sub(vyi, Simd::gather(vy, j)), uy));
+					const Mask active = Simd::both(Simd::both(Simd::less(zero, q), Simd::less(q, one)), Simd::less(zero, u));
+					const Float I = Simd::mul(Simd::mul(dt_half_v, Simd::sub(one, q)),
+						Simd::add(Simd::mul(alpha_v, u), Simd::mul(beta_v, Simd::mul(u, u))));
+					dvx_v = Simd::sub(dvx_v, Simd::select(active, Simd::mul(I, ux)));
+					dvy_v = Simd::sub(dvy_v, Simd::select(active, Simd::mul(I, uy)));
+				}
+				for (; n < row_end; n++)
+				{
+					const NeighbourPair& pair = pairs.pairs[n];
+					if (pair.q == 0.0f || pair.q >= 1.0f)
+						continue;
+					const int j = pair.j;
+					const float ux = pair.unit.x, uy = pair.unit.y;
+					const float u = (vx[i] - vx[j]) * ux + (vy[i] - vy[j]) * uy;
+					if (u > 0)
+					{
+						const float I = dt_half * (1 - pair.q) * (alpha * u + beta * u * u);
+						dvx -= I * ux;
+						dvy -= I * uy;
+					}
+				}
+
+				dvx += Simd::sum(dvx_v);
+				dvy += Simd::sum(dvy_v);
+				vx_out[i] = vx[i] + dvx;
+				vy_out[i] = vy[i] + dvy;
+				particles.x[i] += dvx * dt;
+				particles.y[i] += dvy * dt;
+			}
+		}
+#else
+		//	The list holds every pair from both sides. From j's side the unit vector is reversed, so u is the
+		//	same and j gets the opposite impulse, which is what the in-place version gave it.
+		void viscosityPairs(const ParticleView& particles, int begin, int end, const PairView& pairs, const StepConstants& c,
+			float* vx_out, float* vy_out)
+		{
+			const float dt = c.dt, dt_half = c.dt / 2.0f;
+			const float alpha = c.alpha_viscosity, beta = c.beta_viscosity;
+			const float* vx = particles.vx;
+			const float* vy = particles.vy;
+
+			for (int i = begin; i < end; i++)
+			{
+				const NeighbourPair* row_end = pairs.pairs + pairs.start[i + 1];
+				float dvx = 0.0f, dvy = 0.0f;
+
+				for (const NeighbourPair* pair = pairs.pairs + pairs.start[i]; pair != row_end; pair++)
+				{
+					if (pair->q == 0.0f || pair->q >= 1.0f)
+						continue;
+					const int j = pair->j;
+					const float ux = pair->unit.x, uy = pair->unit.y;
+
+					const float u = (vx[i] - vx[j]) * ux + (vy[i] - vy[j]) * uy;
+					if (u > 0)
+					{
+						const float I = dt_half * (1 - pair->q) * (alpha * u + beta * u * u);
+						dvx -= I * ux;
+						dvy -= I * uy;
+					}
+				}
+
+				vx_out[i] = vx[i] + dvx;
+				vy_out[i] = vy[i] + dvy;
+				particles.x[i] += dvx * dt;
+				particles.y[i] += dvy * dt;
+			}
+		}
+#endif
+
+		void integrateBeginOne(const ParticleView& particles, int i, float dv_y, float dt)
+		{
+			particles.vy[i] += dv_y;
+			particles.px[i] = particles.x[i];
+			particles.py[i] = particles.y[i];
+			particles.x[i] += particles.vx[i] * dt;
+			particles.y[i] += particles.vy[i] * dt;
+		}
+
+		//	Branchless: the clamp is a min and a max, and the previous position takes the clamped value where
+		//	it differs from the position.
+		void integrateEndOne(const ParticleView& particles, int i, const IntegrationBox& box, float inv_dt, Vec2i* tiles_out)
+		{
+			const float x = particles.x[i], y = particles.y[i];
+			float cx = x < box.min_x ? box.min_x : x, cy = y < box.min_y ? box.min_y : y;
+			cx = cx > box.max_x ? box.max_x : cx;
+			cy = cy > box.max_y ? box.max_y : cy;
+			const float px = cx == x ? particles.px[i] : cx, py = cy == y ? particles.py[i] : cy;
+			particles.x[i] = cx;
+			particles.y[i] = cy;
+			particles.px[i] = px;
+			particles.py[i] = py;
+			particles.vx[i] = (cx - px) * inv_dt;
+			particles.vy[i] = (cy - py) * inv_dt;
+			tiles_out[i].x = (int)floorf(cx / box.cell_w);
+			tiles_out[i].y = (int)floorf(cy / box.cell_h);
+		}
+
+#if defined(__AVX2__)
+		void integrateBegin(const ParticleView& particles, int begin, int end, float dv_y, float dt)
+		{
+			const Simd::Float dv_y_v = Simd::set(dv_y), dt_v = Simd::set(dt);
+			int i = begin;
+			for (; i + Simd::WIDTH <= end; i += Simd::WIDTH)
+			{
+				const Simd::Float x = Simd::load(particles.x + i), y = Simd::load(particles.y + i);
+				const Simd::Float vy = Simd::add(Simd::load(particles.vy + i), dv_y_v);
+				Simd::store(particles.vy + i, vy);
+				Simd::store(particles.px + i, x);
+				Simd::store(particles.py + i, y);
+				Simd::store(particles.x + i, Simd::add(x, Simd::mul(Simd::load(particles.vx + i), dt_v)));
+				Simd::store(particles.y + i, Simd::add(y, Simd::mul(vy, dt_v)));
+			}
+			for (; i < end; i++)
+				integrateBeginOne(particles, i, dv_y, dt);
+		}
+
+		void integrateEnd(const ParticleView& particles, int begin, int end, const IntegrationBox& box, float inv_dt,
+			Vec2i* tiles_out)
+		{
+			typedef Simd::Float Float;
+			const Float min_x = Simd::set(box.min_x), min_y = Simd::set(box.min_y);
+			const Float max_x = Simd::set(box.max_x), max_y = Simd::set(box.max_y);
+			const Float cell_w = Simd::set(box.cell_w), cell_h = Simd::set(box.cell_h), inv_dt_v = Simd::set(inv_dt);
+			int i = begin;
+			for (; i + Simd::WIDTH <= end; i += Simd::WIDTH)
+			{
+				const Float x = Simd::load(particles.x + i), y = Simd::load(particles.y + i);
+				const Float cx = Simd::min(Simd::max(x, min_x), max_x), cy = Simd::min(Simd::max(y, min_y), max_y);
+				const Float px = Simd::choose(Simd::equal(cx, x), Simd::load(particles.px + i), cx);
+				const Float py = Simd::choose(Simd::equal(cy, y), Simd::load(particles.py + i), cy);
+				Simd::store(particles.x + i, cx);
+				Simd::store(particles.y + i, cy);
+				Simd::store(particles.px + i, px);
+				Simd::store(particles.py + i, py);
+				Simd::store(particles.vx + i, Simd::mul(Simd::sub(cx, px), inv_dt_v));
+				Simd::store(particles.vy + i, Simd::mul(Simd::sub(cy, py), inv_dt_v));
+
+				int tile_x[Simd::WIDTH], tile_y[Simd::WIDTH];
+				Simd::storeKeys(tile_x, Simd::floorToInt(Simd::div(cx, cell_w)));
+				Simd::storeKeys(tile_y, Simd::floorToInt(Simd::div(cy, cell_h)));
+				for (int l = 0; l < Simd::WIDTH; l++)
+				{
+					tiles_out[i + l].x = tile_x[l];
+					tiles_out[i + l].y = tile_y[l];
+				}
+			}
+			for (; i < end; i++)
+				integrateEndOne(particles, i, box, inv_dt, tiles_out);
+		}
+#else
+		void integrateBegin(const ParticleView& particles, int begin, int end, float dv_y, float dt)
+		{
+			for (int i = begin; i < end; i++)
+				integrateBeginOne(particles, i, dv_y, dt);
+		}
+
+		void integrateEnd(const ParticleView& particles, int begin, int end, const IntegrationBox& box, float inv_dt,
+			Vec2i* tiles_out)
+		{
+			for (int i = begin; i < end; i++)
+				integrateEndOne(particles, i, box, inv_dt, tiles_out);
+		}
+#endif
+
+		void springLengths(const ParticleView& particles, const int* keys, const float* rest_lengths, int count, int stride,
+			const StepConstants& c, float* lengths_out)
+		{
+			const float dt = c.dt, yield_ratio = c.yield_ratio, plasticity = c.plasticity;
+			const float* x = particles.x;
+			const float* y = particles.y;
+
+			for (int k = 0; k < count; k++)
+			{
+				const int key = keys[k];
+				const int a = key / stride, b = key % stride;
+				const float rx = x[b] - x[a], ry = y[b] - y[a];
+				const float r = sqrtf(rx * rx + ry * ry);
+				const float L_ij = rest_lengths[key];
+				const float d = yield_ratio * L_ij;
+
+				float L = L_ij;
+				if (r > L_ij + d)
+				{
+					L += dt * plasticity * (r - L_ij - d);
+				}
+				else if (r < L_ij - d)
+				{
+					L -= dt * plasticity * (L_ij - d - r);
+				}
+				lengths_out[k] = L;
+			}
+		}
+
+		void springDisplacements(const ParticleView& particles, const int* keys, const float* rest_lengths, int count, int stride,
+			const StepConstants& c, Vec2f* displacements_out)
+		{
+			const float inv_h = c.inv_h, spring_term = c.dt2 * c.k_spring / 2.0f;
+			const float* x = particles.x;
+			const float* y = particles.y;
+
+			for (int k = 0; k < count; k++)
+			{
+				const int key = keys[k];
+				const int a = key / stride, b = key % stride;
+				const float rx = x[b] - x[a], ry = y[b] - y[a];
+				const float r = sqrtf(rx * rx + ry * ry);
+				float ux = rx / r, uy = ry / r;
+				if (r == 0)
+					randomUnit(ux, uy);
+				const float len = rest_lengths[key];
+				const float D = spring_term * (1 - len * inv_h) * (len - r);
+				displacements_out[k].x = D * ux;
+				displacements_out[k].y = D * uy;
+			}
+		}
+
+		void collideCircle(float& x, float& y, const ObjectView& object)
+		{
+			float dx = x - object.position.x, dy = y - object.position.y;
+			const float length = sqrtf(dx * dx + dy * dy);
+			if (length > object.radius)
+				return;
+			const float scale = (object.radius - length) / length;
+			x += dx * scale;
+			y += dy * scale;
+		}
+
+		void collidePolygon(float& x, float& y, const ObjectView& object)
+		{
+			if (x < object.min.x || y < object.min.y || x > object.max.x || y > object.max.y)
+				return;
+
+			float smallestDot = 1000000000.0f;
+			float best_x = 0.0f, best_y = 0.0f;
+
+			bool all_positive = true, all_negative = true;
+			for (int i = 0; i < object.vertex_count; i++)
+			{
+				const float dot = (x - object.vertices[i].x) * object.normals[i].x
+					+ (y - object.vertices[i].y) * object.normals[i].y;
+				all_positive &= (dot >= 0);
+				all_negative &= (dot <= 0);
+				if (!all_positive && !all_negative)
+					return;
+				if (fabsf(dot) < fabsf(smallestDot))
+				{
+					smallestDot = dot;
+					best_x = object.normals[i].x;
+					best_y = object.normals[i].y;
+				}
+			}
+			x -= best_x * smallestDot;
+			y -= best_y * smallestDot;
+		}
+
+		void collide(const ParticleView& particles, int begin, int end, const ObjectView* objects, int object_count)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				for (int j = 0; j < object_count; j++)
+				{
+					if (objects[j].shape == ObjectShapeType::CIRCLE)
+						collideCircle(particles.x[i], particles.y[i], objects[j]);
+					else
+						collidePolygon(particles.x[i], particles.y[i], objects[j]);
+				}
+			}
+		}
+
+		//	Vector from the nearest surface point within stickness_distance to (px, py), or zero.
+		void nearestVector(float px, float py, const ObjectView& object, float stickness_distance, float& x, float& y)
+		{
+			x = y = 0.0f;
+			if (object.shape == ObjectShapeType::CIRCLE)
+			{
+				const float dx = px - object.position.x, dy = py - object.position.y;
+				const float len = sqrtf(dx * dx + dy * dy);
+				if (len >= object.radius + stickness_distance)
+					return;
+				const float scale = (object.radius + stickness_distance - len) / len;
+				x = dx * scale;
+				y = dy * scale;
+				return;
+			}
+
+			if (px < object.min.x - stickness_distance || py < object.min.y - stickness_distance
+				|| px > object.max.x + stickness_distance || py > object.max.y + stickness_distance)
+				return;
+
+			float smallest = 1000000000.0f;
+			for (int i = 0; i < object.vertex_count; i++)
+			{
+				const Vec2f& a = object.vertices[i];
+				const Vec2f& b = object.vertices[(i + 1) % object.vertex_count];
+				const float ex = b.x - a.x, ey = b.y - a.y;
+				const float len = sqrtf(ex * ex + ey * ey);
+				const float vx = px - a.x, vy = py - a.y;
+				const float dot = (ex * vx + ey * vy) / len;
+
+				if (dot > 0 && dot < len)
+				{
+					const float distance = vx * object.normals[i].x + vy * object.normals[i].y;
+					if (distance < smallest && distance > 0 && distance < stickness_distance)
+					{
+						x = object.normals[i].x * distance;
+						y = object.normals[i].y * distance;
+						smallest = distance;
+					}
+				}
+			}
+		}
+
+		void stick(const ParticleView& particles, int begin, int end, const ObjectView* objects, int object_count, const StepConstants& c)
+		{
+			const float dt = c.dt, k_stick = c.k_stick, stickness_distance = c.stickness_distance;
+
+			for (int i = begin; i < end; i++)
+			{
+				for (int j = 0; j < object_count; j++)
+				{
+					float x, y;
+					nearestVector(particles.x[i], particles.y[i], objects[j], stickness_distance, x, y);
+					if (x != 0.0f || y != 0.0f)
+					{
+						const float len = sqrtf(x * x + y * y);
+						const float sticky_term = dt * k_stick * len * (1 - len / stickness_distance) * -1;
+						particles.x[i] += x / len * sticky_term;
+						particles.y[i] += y / len * sticky_term;
+					}
+				}
+			}
+		}
+	}
+
+	extern const KernelTable table = {
+		FLUID_KERNEL_NAME, densityTile, densityCompact, densityPressure, densityGather, viscosityTile, densityPairs, viscosityPairs,
+		springLengths, springDisplacements, integrateBegin, integrateEnd, collide, stick
+	};
+}
@@ -0,0 +1,4 @@
+//	Kernel variant built with the sse4.2 flags set in CMakeLists.txt.
+#define FLUID_KERNEL_NAMESPACE kernels_sse42
+#define FLUID_KERNEL_NAME "sse4.2"
+#include "KernelsImpl.inl"
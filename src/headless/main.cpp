@@ -0,0 +1,306 @@
+#include "core/Simulation.hpp"
+#include "core/Scenes.hpp"
+#include "core/CpuDispatch.hpp"
+#include "core/Parallel.hpp"
+#include "core/Ensemble.hpp"
+#include "core/Autotune.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+//	Runs a scene without a window as fast as possible and reports the step rate.
+
+static void printUsage()
+{
+	std::cout << "usage: fluid_headless [options]\n"
+		<< "  --scene NAME     scene to run (";
+	const int SCENES_SIZE = (int)scenes::all().size();
+	for (int i = 0; i < SCENES_SIZE; i++)
+		std::cout << (i ? ", " : "") << scenes::all()[i].name;
+	std::cout << "), default block\n"
+		<< "  --steps N        number of measured steps, default 1000\n"
+		<< "  --warmup N       steps to run before measuring, default 0\n"
+		<< "  --dt SECONDS     time step, default " << SimulationConfig().dt << "\n"
+		<< "  --set NAME=VALUE override a SimulationConfig parameter, e.g. k_spring=100\n"
+		<< "  --seed N         seed for the random number generator\n"
+		<< "  --isa NAME       kernel variant: generic, sse4.2, avx2 or avx512 (default: best supported,\n"
+		<< "                   or the FLUID_ISA environment variable)\n"
+		<< "  --threads N      worker threads, default every hardware thread\n"
+		<< "  --backend NAME   parallel backend: openmp or pool (default: openmp when built with it)\n"
+		<< "  --profile        print the average time spent in each phase\n"
+		<< "  --grid LAYOUT    neighbour grid: nested (per-cell vectors, default), sorted (counting sort) or\n"
+		<< "                   hashed (counting sort over the occupied cells only)\n"
+		<< "  --unbounded      no walls, particles may leave the world (implies --grid hashed)\n"
+		<< "  --reorder N      sort the particles into Morton order of their cells every N steps\n"
+		<< "  --pairs          build one neighbour pair list per step and share it between the phases\n"
+		<< "  --skin S         with --pairs, keep neighbours within h * (1 + S) and only rebuild the list once a\n"
+		<< "                   particle has moved S * h / 2\n"
+		<< "  --compact        relax on 16-bit cell-relative positions (implies --grid sorted unless hashed)\n"
+		<< "  --jacobi         relax against a snapshot of the positions in two uncoloured passes\n"
+		<< "  --jacobi-weight W with --jacobi, fraction of the gathered displacement applied, default 0.5\n"
+		<< "  --tile-order O   order of the tiles in each colour: cost (most occupied first, default) or shuffled\n"
+		<< "  --autotune       time candidate thread counts, chunk sizes and cell sizes on the scene first and\n"
+		<< "                   use the fastest (cached per host and particle count)\n"
+		<< "  --retune         like --autotune but ignore the cache\n"
+		<< "  --tune-cache FILE autotune cache, default fluid_autotune.cache\n"
+		<< "  --sweep NAME=V1,V2,... or NAME=FROM:TO:STEP\n"
+		<< "                   run the scene once per combination of the swept parameters, in parallel,\n"
+		<< "                   and print steps/sec, density error and max velocity per run as CSV\n"
+		<< "  --out FILE       write the sweep table to FILE instead of stdout\n";
+}
+
+static int runSweep(const std::string& scene, int steps, int warmup, const SimulationConfig& config, const StepTuning& tuning,
+	const std::vector<ensemble::Axis>& axes, const std::string& out_path)
+{
+	ensemble::Options options;
+	options.scene = scene;
+	options.steps = steps;
+	options.warmup = warmup;
+	options.base = config;
+	options.tuning = tuning;
+	options.axes = axes;
+
+	std::cerr << "sweeping " << ensemble::runCount(axes) << " runs of " << scene << " on " << parallel::threadCount()
+		<< " threads (" << parallel::backendName(parallel::backend()) << ")\n";
+	const int spring_runs = ensemble::springRunCount(options);
+	if (spring_runs > 0)
+	{
+		size_t table_bytes;
+		const int concurrency = ensemble::springConcurrency(options, table_bytes);
+		if (concurrency == 0)
+		{
+			std::cerr << "springs need a " << table_bytes / 1e6 << " MB table per run (at most "
+				<< ParticleSprings::MAX_TABLE_BYTES / 1e6 << " MB): use fewer particles or k_spring=0\n";
+			return 1;
+		}
+		std::cerr << spring_runs << " runs use springs: " << table_bytes / 1e6 << " MB spring table each, at most "
+			<< concurrency << " at a time\n";
+	}
+	Clock clock;
+	std::vector<ensemble::RunResult> results;
+	if (!ensemble::run(options, results))
+	{
+		std::cerr << "unknown scene: " << scene << "\n";
+		printUsage();
+		return 1;
+	}
+	std::cerr << "done in " << clock.restart() / 1e6f << " s\n";
+
+	if (out_path.empty())
+	{
+		ensemble::writeTable(std::cout, options, results);
+		return 0;
+	}
+	std::ofstream out(out_path);
+	ensemble::writeTable(out, options, results);
+	if (!out)
+	{
+		std::cerr << "could not write " << out_path << "\n";
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string scene = "block";
+	int steps = 1000, warmup = 0;
+	SimulationConfig config;
+	bool profile = false;
+	std::vector<ensemble::Axis> axes;
+	std::string out_path;
+	bool autotune = false, retune = false;
+	StepTuning tuning;
+	std::string tune_cache = "fluid_autotune.cache";
+	unsigned int seed = time(NULL);
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+		if (!strcmp(argv[i], "--scene") && has_value)
+			scene = argv[++i];
+		else if (!strcmp(argv[i], "--steps") && has_value)
+			steps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--warmup") && has_value)
+			warmup = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--dt") && has_value)
+			config.dt = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--set") && has_value)
+		{
+			const std::string assignment = argv[++i];
+			const size_t eq = assignment.find('=');
+			float* value = eq == std::string::npos ? nullptr : config.parameter(assignment.substr(0, eq));
+			if (value == nullptr)
+			{
+				std::cerr << "unknown parameter: " << assignment << "\n";
+				return 1;
+			}
+			*value = atof(assignment.c_str() + eq + 1);
+		}
+		else if (!strcmp(argv[i], "--seed") && has_value)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--isa") && has_value)
+		{
+			Isa isa;
+			if (!cpu::parseIsa(argv[++i], isa) || !cpu::selectIsa(isa))
+			{
+				std::cerr << "kernel variant " << argv[i] << " is not available, " << cpu::report() << "\n";
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--threads") && has_value)
+			parallel::setThreadCount(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--backend") && has_value)
+		{
+			const std::string name = argv[++i];
+			const bool known = name == "openmp" || name == "pool";
+			if (!known || !parallel::setBackend(name == "openmp" ? parallel::Backend::OPENMP : parallel::Backend::THREAD_POOL))
+			{
+				std::cerr << "parallel backend " << name << " is not available\n";
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--sweep") && has_value)
+		{
+			ensemble::Axis axis;
+			if (!ensemble::parseAxis(argv[++i], axis))
+			{
+				std::cerr << "bad sweep: " << argv[i] << "\n";
+				return 1;
+			}
+			axes.push_back(axis);
+		}
+		else if (!strcmp(argv[i], "--grid") && has_value)
+		{
+			if (!parseGridLayout(argv[++i], tuning.grid_layout))
+			{
+				std::cerr << "unknown grid layout: " << argv[i] << "\n";
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--unbounded"))
+			config.bounded = false;
+		else if (!strcmp(argv[i], "--reorder") && has_value)
+			tuning.reorder_interval = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--pairs"))
+			tuning.pair_list = true;
+		else if (!strcmp(argv[i], "--tile-order") && has_value)
+		{
+			const std::string order = argv[++i];
+			if (order != "cost" && order != "shuffled")
+			{
+				std::cerr << "unknown tile order: " << order << "\n";
+				return 1;
+			}
+			tuning.cost_order = order == "cost";
+		}
+		else if (!strcmp(argv[i], "--compact"))
+			tuning.compact = true;
+		else if (!strcmp(argv[i], "--jacobi"))
+			tuning.jacobi = true;
+		else if (!strcmp(argv[i], "--jacobi-weight") && has_value)
+			tuning.jacobi_weight = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--skin") && has_value)
+			tuning.verlet_skin = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--autotune"))
+			autotune = true;
+		else if (!strcmp(argv[i], "--retune"))
+			autotune = retune = true;
+		else if (!strcmp(argv[i], "--tune-cache") && has_value)
+			tune_cache = argv[++i];
+		else if (!strcmp(argv[i], "--out") && has_value)
+			out_path = argv[++i];
+		else if (!strcmp(argv[i], "--profile"))
+			profile = true;
+		else
+		{
+			printUsage();
+			return !strcmp(argv[i], "--help") ? 0 : 1;
+		}
+	}
+
+	srand(seed);
+
+	if (!axes.empty())
+		return runSweep(scene, steps, warmup, config, tuning, axes, out_path);
+
+	Simulation sim(config);
+	sim.setTuning(tuning);
+	if (!scenes::load(sim, scene))
+	{
+		std::cerr << "unknown scene: " << scene << "\n";
+		printUsage();
+		return 1;
+	}
+	if (!sim.reserveSprings())
+	{
+		std::cerr << "springs need room for " << sim.springs.maxParticleAmount << " particles, a "
+			<< ParticleSprings::tableBytes(sim.springs.maxParticleAmount) / 1e6 << " MB table (at most "
+			<< ParticleSprings::MAX_TABLE_BYTES / 1e6 << " MB): use fewer particles or k_spring=0\n";
+		return 1;
+	}
+
+	if (autotune)
+	{
+		bool from_cache;
+		const autotune::Settings settings = autotune::apply(sim, tune_cache, retune, 20, from_cache);
+		std::cout << "autotune (" << (from_cache ? "cached" : "measured") << ", " << autotune::hostName() << ", bucket "
+			<< autotune::bucket(sim.particles.size()) << "): " << settings.describe() << "\n";
+	}
+
+	for (int i = 0; i < warmup; i++)
+		sim.update();
+
+	StepTimings total;
+	Clock clock;
+	for (int i = 0; i < steps; i++)
+	{
+		sim.update();
+		total += sim.timings;
+	}
+	const float seconds = clock.restart() / 1e6f;
+
+	std::cout << "scene: " << scene << ", particles: " << sim.particles.size() << ", steps: " << steps
+		<< ", features: " << features::describe(sim.active_features);
+	const int CHANNELS_SIZE = (int)sim.particles.channels.size();
+	for (int c = 0; c < CHANNELS_SIZE; c++)
+		std::cout << (c ? " " : ", channels: ") << sim.particles.channels[c].name;
+	std::cout << "\n"
+		<< cpu::report() << "\n"
+		<< "threads: " << parallel::threadCount() << " (" << parallel::backendName(parallel::backend()) << ")\n"
+		<< "time: " << seconds << " s, steps/sec: " << (seconds > 0 ? steps / seconds : 0.0f) << "\n";
+
+	if (profile && steps > 0)
+	{
+		const float ms = 1000.0f * steps;
+		std::cout << "average ms per step:\n"
+			<< "  viscosity      " << total.viscosity / ms << "\n"
+			<< "  gravity/predict " << total.velocity / ms << "\n"
+			<< "  adjust springs " << total.adjust_springs / ms << "\n"
+			<< "  apply springs  " << total.apply_springs / ms << "\n"
+			<< "  relaxation     " << total.relaxation / ms << "\n"
+			<< "  stickiness     " << total.stickiness / ms << "\n"
+			<< "  collisions     " << total.collisions / ms << "\n"
+			<< "  bounds/grid    " << total.bounds_update / ms << "\n"
+			<< "  reorder        " << total.reorder / ms << "\n"
+			<< "  neighbours     " << total.neighbours / ms << "\n"
+			<< "  total          " << total.total() / ms << "\n"
+			<< "tile sweeps: " << total.tile_idle / ms << " ms idle per member per step\n"
+			<< "relaxation traffic (estimate from neighbour visits, not measured): "
+			<< total.relaxation_bytes / (1e6f * steps) << " MB per step, "
+			<< (sim.tuning.pair_list ? "pair list" : sim.tuning.jacobi ? "jacobi" : sim.tuning.compact ? "compact positions" : "float positions")
+			<< "\n";
+		if (sim.tuning.compact && !sim.tuning.pair_list && !sim.tuning.jacobi)
+			std::cout << "compact relaxation: fell back to floats on " << total.compact_fallbacks << " of " << steps << " steps\n";
+		if (sim.tuning.pair_list)
+		{
+			std::cout << "neighbour list: rebuilt " << total.neighbour_rebuilds << " of " << steps << " steps";
+			if (total.neighbour_rebuilds > 0)
+				std::cout << " (every " << steps / total.neighbour_rebuilds << ")";
+			std::cout << ", skin " << sim.tuning.verlet_skin << " h, " << sim.neighbours.pairCount() << " pairs\n";
+		}
+	}
+}
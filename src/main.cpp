@@ -1,5 +1,7 @@
 #include <SFML/Graphics.hpp>
-#include "Simulation.hpp"
+#include "core/Simulation.hpp"
+#include "core/Scenes.hpp"
+#include "SimulationRenderer.hpp"
 #include "Conf.hpp"
 #include "MouseHandler.hpp"
 #include "Menu.hpp"
@@ -19,7 +21,14 @@ int main()
 	conf::circle.setOrigin(sf::Vector2f(conf::particle_radius, conf::particle_radius));
 	conf::circle.setPointCount(9);
 	
-	Simulation sim;
+	SimulationConfig config;
+	config.X = conf::X;
+	config.Y = conf::Y;
+	config.particle_radius = conf::particle_radius;
+
+	Simulation sim(config);
+	scenes::block(sim);
+	SimulationRenderer renderer(sim);
 	MouseInputHandler mouse_handler(sim);
 	Menu menu(sim);
 	sf::Clock clock;
@@ -44,9 +53,9 @@ int main()
 
 		menu.update(sf::Mouse::getPosition(conf::window));
 
-		sim.update(conf::dt);
+		sim.update();
 
-		conf::window.draw(sim);
+		conf::window.draw(renderer);
 		conf::window.draw(menu);
 		conf::window.draw(mouse_handler);
 